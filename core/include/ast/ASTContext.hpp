@@ -9,8 +9,14 @@
 #include <deque>
 #include <memory>
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <string_view>
 #include <ast/ast.hpp>
+#include <support/identifier_table.hpp>
 
 namespace udo::ast {
 
@@ -38,23 +44,47 @@ class ASTContext {
 public:
     template <typename VecAlloc = std::allocator<Slab>>
     class BumpPtrAllocator {
+        static constexpr std::size_t num_size_classes = std::numeric_limits<std::size_t>::digits;
+        static constexpr std::size_t not_partially_used = std::numeric_limits<std::size_t>::max();
+
+        /// where a slab sits in `partially_used_slabs`
+        struct Partial_Slot {
+            std::size_t size_class = not_partially_used;
+            std::size_t index = 0;
+        };
+
         std::deque<Slab, VecAlloc> slabs;
-        std::vector<std::size_t> partially_used_slabs;
+        std::deque<Slab, VecAlloc> large_slabs;     // one per allocation too big for a slab, sized to fit it exactly
+        /// indices of slabs with room left besides the current one, bucketed by floor(log2(remaining capacity))
+        std::array<std::vector<std::size_t>, num_size_classes> partially_used_slabs;
+        std::vector<Partial_Slot> partial_slots;    // one per slab
+        std::uint64_t used_size_classes = 0;        // bit k is set while bucket k is not empty
+        std::size_t partially_used_count = 0;
         std::size_t current_slab_idx{};
         std::size_t slab_size;
 
+        static std::size_t size_class(std::size_t remaining) { return std::bit_width(remaining) - 1; }
+        void add_partially_used(std::size_t idx);
+        void remove_partially_used(std::size_t idx);
+
     public:
         explicit BumpPtrAllocator(std::size_t initial_slab_size = 1024 * 1024);
 
         /// @brief Allocates storage of at least the size (may allocate more than requested due to cache line alignment) and returns a pointer to it.
         /// If the current slab does not have enough space, a new slab is allocated.
         ///
+        /// Partially used slabs are bucketed by how much room they have left, so finding one to reuse
+        /// skips every bucket too small for `size` and does not depend on how many slabs there are.
+        ///
+        /// A request too big for a new slab gets a dedicated slab of its exact size, kept apart from the
+        /// others, and the current slab stays current.
+        ///
         /// @param size the size of the memory chunk being allocated
         /// @param alignment alignment of chunk within the slab
         /// @param size_of_new_slab size of the new slab to be allocated if the current slab is full, a value <0 means to use member slab_size to construct the new slab
         /// @param reuse_free_slab if true, the allocator would try to reuse the slab that was cast aside in favor of a new bigger slab when allocating storage more than the available amount in the current slab.
         ///
-        /// @returns pointer to the allocated memory chunk, or nullptr if allocation fails (e.g. if even a new slab cannot accommodate the requested size - fix: increase size_of_new_slab to allocate a new slab of a custom size)
+        /// @returns pointer to the allocated memory chunk
         void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t),
                        std::size_t size_of_new_slab = 0, bool reuse_free_slab = true);
 
@@ -62,21 +92,30 @@ public:
 
         [[nodiscard]] int current_slab_index() const { return current_slab_idx; }
         [[nodiscard]] std::size_t num_slabs() const { return slabs.size(); }
-        [[nodiscard]] std::size_t num_partially_used_slabs() const { return partially_used_slabs.size(); }
+        [[nodiscard]] std::size_t num_partially_used_slabs() const { return partially_used_count; }
+        [[nodiscard]] std::size_t num_large_slabs() const { return large_slabs.size(); }
 
+        /// both count large slabs too
         [[nodiscard]] std::size_t num_allocated_bytes() const;
         [[nodiscard]] std::size_t num_allocated_bytes_used() const;
         [[nodiscard]] std::size_t slab_sizes() const { return slab_size; }
     };
 
 private:
+    static constexpr std::size_t identifier_slab_size = 64 * 1024;
+
     BumpPtrAllocator<> allocator;
+    // Spellings get an arena of their own, which only the table touches and only under its lock, so
+    // identifiers can be interned from any thread while the parser keeps allocating nodes unlocked
+    BumpPtrAllocator<> identifier_allocator;
+    IdentifierTable identifiers;    // spellings are interned into `identifier_allocator`
     TranslationUnitDecl* tu_decl;
 
 public:
     explicit ASTContext(std::size_t initial_slab_size = 1024 * 1024);
 
     [[nodiscard]] TranslationUnitDecl* get_translation_unit_decl() const { return tu_decl; }
+    [[nodiscard]] IdentifierTable& get_identifier_table() { return identifiers; }
 
     void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t)) {
         return allocator.allocate(size, alignment);
@@ -96,6 +135,11 @@ public:
         storage[str.size()] = '\0';
         return storage;
     }
+
+    /// allocate_string behind a plain function pointer, `context` is the ASTContext, e.g. for the lexer's String_Storage
+    static const char* store_string(void* context, std::string_view str) {
+        return static_cast<ASTContext*>(context)->allocate_string(str);
+    }
 };
 
 } // namespace udo::ast
@@ -107,21 +151,56 @@ template <typename VecAlloc>
 ASTContext::BumpPtrAllocator<VecAlloc>::BumpPtrAllocator(const std::size_t initial_slab_size)
     : slab_size(initial_slab_size) {
     slabs.emplace_back(slab_size);
+    partial_slots.emplace_back();
+}
+
+template <typename VecAlloc>
+void ASTContext::BumpPtrAllocator<VecAlloc>::add_partially_used(const std::size_t idx) {
+    const std::size_t cls = size_class(slabs[idx].get_remaining_capacity());
+    partial_slots[idx] = {cls, partially_used_slabs[cls].size()};
+    partially_used_slabs[cls].push_back(idx);
+    used_size_classes |= std::uint64_t{1} << cls;
+    ++partially_used_count;
+}
+
+template <typename VecAlloc>
+void ASTContext::BumpPtrAllocator<VecAlloc>::remove_partially_used(const std::size_t idx) {
+    const auto [cls, index] = partial_slots[idx];
+    if (cls == not_partially_used) return;
+
+    // swap with the last slab of the bucket so removal is O(1)
+    std::vector<std::size_t>& bucket = partially_used_slabs[cls];
+    bucket[index] = bucket.back();
+    partial_slots[bucket[index]].index = index;
+    bucket.pop_back();
+    if (bucket.empty()) used_size_classes &= ~(std::uint64_t{1} << cls);
+
+    partial_slots[idx] = {};
+    --partially_used_count;
 }
 
 template <typename VecAlloc>
 void* ASTContext::BumpPtrAllocator<VecAlloc>::allocate(const std::size_t size, const std::size_t alignment,
                                                       const std::size_t size_of_new_slab, const bool reuse_free_slab) {
-    if (reuse_free_slab && !partially_used_slabs.empty()) {
-        for (auto it = partially_used_slabs.begin(); it != partially_used_slabs.end(); ) {
-            Slab& slab = slabs[*it];
-            if (void* result = slab.allocate(size, alignment)) {
-                if (slab.get_remaining_capacity() == 0) {
-                    it = partially_used_slabs.erase(it);
-                }
+    const std::size_t new_slab_size = size_of_new_slab > 0 ? size_of_new_slab : slab_size;
+    // slab buffers come from operator new[], so only alignments past max_align_t can need padding at the start
+    const std::size_t worst_padding = alignment > alignof(std::max_align_t) ? alignment - alignof(std::max_align_t) : 0;
+    if (size + worst_padding > new_slab_size) {
+        large_slabs.emplace_back(size + worst_padding);
+        return large_slabs.back().allocate(size, alignment);
+    }
+
+    if (reuse_free_slab && used_size_classes != 0) {
+        // slabs in buckets below the one `size` falls in are too small for it. The rest are tried smallest
+        // bucket first, one slab per bucket, as padding can still make a slab in the first bucket miss
+        const std::uint64_t large_enough = ~std::uint64_t{0} << size_class(std::max<std::size_t>(size, 1));
+        for (std::uint64_t classes = used_size_classes & large_enough; classes != 0; classes &= classes - 1) {
+            const std::size_t idx = partially_used_slabs[std::countr_zero(classes)].back();
+            if (void* result = slabs[idx].allocate(size, alignment)) {
+                remove_partially_used(idx);
+                if (slabs[idx].get_remaining_capacity() > 0) add_partially_used(idx);
                 return result;
             }
-            ++it;
         }
     }
 
@@ -130,15 +209,11 @@ void* ASTContext::BumpPtrAllocator<VecAlloc>::allocate(const std::size_t size, c
     }
 
     if (slabs[current_slab_idx].get_remaining_capacity() > 0) {
-        partially_used_slabs.push_back(current_slab_idx);
-    }
-
-    const std::size_t new_slab_size = size_of_new_slab > 0 ? size_of_new_slab : slab_size;
-    if (new_slab_size <= size) {
-        return nullptr;
+        add_partially_used(current_slab_idx);
     }
 
     slabs.emplace_back(new_slab_size);
+    partial_slots.emplace_back();
     current_slab_idx = slabs.size() - 1;
 
     return slabs[current_slab_idx].allocate(size, alignment);
@@ -149,11 +224,9 @@ void ASTContext::BumpPtrAllocator<VecAlloc>::reset_slab(std::size_t idx) {
     Slab& slab = slabs[idx];
     slab.reset();
 
-    auto it = std::ranges::find(partially_used_slabs, idx);
-    if (it != partially_used_slabs.end()) {
-        partially_used_slabs.erase(it);
-    }
-    partially_used_slabs.insert(partially_used_slabs.begin(), idx);
+    // the slab moves to the bucket of its full capacity, the current slab is always tried anyway
+    remove_partially_used(idx);
+    if (idx != current_slab_idx && slab.get_remaining_capacity() > 0) add_partially_used(idx);
 }
 
 template<typename VecAlloc>
@@ -162,6 +235,9 @@ std::size_t ASTContext::BumpPtrAllocator<VecAlloc>::num_allocated_bytes() const
     for (const auto& slab : slabs) {
         total += slab.capacity;
     }
+    for (const auto& slab : large_slabs) {
+        total += slab.capacity;
+    }
     return total;
 }
 
@@ -171,6 +247,9 @@ std::size_t ASTContext::BumpPtrAllocator<VecAlloc>::num_allocated_bytes_used() c
     for (const auto& slab : slabs) {
         total += slab.current - slab.buffer;
     }
+    for (const auto& slab : large_slabs) {
+        total += slab.current - slab.buffer;
+    }
     return total;
 }
 
@@ -6,6 +6,8 @@
 #define AST_HPP
 
 #include <support/source_manager.hpp>
+#include <support/identifier_table.hpp>
+#include <string_view>
 #include <type_traits>
 
 namespace udo::ast {
@@ -105,6 +107,20 @@ namespace udo::ast {
     };
     static_assert(std::is_trivially_destructible_v<Decl>);
 
+    /// Base class for declarations that introduce a name, which is compared and hashed by pointer.
+    class NamedDecl : public Decl {
+        friend class ASTContext;
+        const IdentifierInfo* name;
+
+    protected:
+        NamedDecl(const Kind K, const IdentifierInfo* name) : Decl(K), name(name) {}
+
+    public:
+        [[nodiscard]] const IdentifierInfo* get_identifier() const { return name; }
+        [[nodiscard]] std::string_view get_name() const { return name ? name->get_name() : std::string_view{}; }
+    };
+    static_assert(std::is_trivially_destructible_v<NamedDecl>);
+
     /// The top-level declaration that represents the entire translation unit.
     class TranslationUnitDecl : public Decl, public DeclContext {
     public:
@@ -5,6 +5,7 @@
 #ifndef COMPILER_CONFIG_HPP
 #define COMPILER_CONFIG_HPP
 
+#include <cstddef>
 #include <string>
 
 namespace udo::compiler_config {
@@ -48,6 +49,9 @@ namespace udo::compiler_config {
         // frontend flags
         bool verbose = false;
         int max_error_count = 20;
+        bool pipeline_frontend = false;   // lex on a thread of its own, feeding the parser as it goes
+        std::size_t prefetch_budget = std::size_t{256} << 20;   // bytes of sources read ahead of the one being compiled
+        std::size_t source_cache_limit = 0;                     // bytes of finished sources kept in memory, 0 for no limit
 
         // backend flags
         Opt_Level     level        = Opt_Level::O1;
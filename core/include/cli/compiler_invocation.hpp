@@ -56,8 +56,12 @@ namespace udo::compiler_config {
     struct Lexer_Invoke {
         /// @brief calling parameters for invocation of the Lexer object
         struct Param {
-            std::istream &input_Stream;
             diag::DiagnosticsEngine& diag;
+            /// stream to lex, read once into storage owned by the Lexer
+            std::istream *input_Stream = nullptr;
+            /// alternatively a file already loaded into `sources`, lexed in place without a copy
+            Source_Manager *sources = nullptr;
+            FileID file = 0;
         };
 
         /// Mutable because Param.inputStream may be altered by Lexer constructor
@@ -66,7 +70,8 @@ namespace udo::compiler_config {
         explicit Lexer_Invoke(const Param &param);
 
         /// @brief Initialize a Lexer object with Lexer constructor params
-        /// @returns Lexer object
+        /// @returns Lexer object, or nullptr if `file` is not loaded in `sources` or there is neither
+        ///          `sources` nor a stream to lex
         std::unique_ptr<Lexer> invoke() const;
     };
 
@@ -75,7 +80,7 @@ namespace udo::compiler_config {
         struct Param {
             diag::DiagnosticsEngine& diag;
             ASTContext& context;
-            std::vector<Token> tokens;
+            TokenSource& tokens;    // usually the Lexer itself, so tokens are lexed as the parser asks for them
             Flags flags;
         };
 
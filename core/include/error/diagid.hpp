@@ -79,6 +79,7 @@ enum : DiagID {
     err_expected_token = DIAG_START_COMMON,
     err_unknown_identifier,
     err_file_not_found,
+    err_file_too_large,
     err_invalid_character,
     err_matched_no_tokens,
     warn_unused_variable,
@@ -97,6 +98,7 @@ enum : DiagID {
     err_invalid_escape_sequence,
     err_empty_character_literal,
     warn_multi_char_constant,
+    err_invalid_utf8,
 };
 } // namespace lex
 
@@ -0,0 +1,86 @@
+//
+// Created by David Yang on 2026-03-04.
+//
+
+#ifndef CHAR_SCAN_HPP
+#define CHAR_SCAN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+namespace udo::lexer {
+
+    // -----------------------------------------------
+    //        ASCII character classes (locale-free)
+    // -----------------------------------------------
+
+    enum Char_Class : std::uint8_t {
+        cc_space        = 1 << 0,   // ' ', \t, \v, \f, \r (newlines are lexed separately)
+        cc_digit        = 1 << 1,   // 0-9
+        cc_alpha        = 1 << 2,   // a-z, A-Z
+        cc_ident_start  = 1 << 3,   // alpha or '_'
+        cc_ident        = 1 << 4,   // alpha, digit or '_'
+    };
+
+    struct Char_Class_Table {
+        std::uint8_t classes[256] = {};
+
+        constexpr Char_Class_Table() {
+            for (const char c : {' ', '\t', '\v', '\f', '\r'}) classes[static_cast<unsigned char>(c)] |= cc_space;
+            for (int c = '0'; c <= '9'; ++c) classes[c] |= cc_digit | cc_ident;
+            for (int c = 'a'; c <= 'z'; ++c) {
+                classes[c] |= cc_alpha | cc_ident_start | cc_ident;
+                classes[c - 'a' + 'A'] |= cc_alpha | cc_ident_start | cc_ident;
+            }
+            classes[static_cast<unsigned char>('_')] |= cc_ident_start | cc_ident;
+        }
+    };
+
+    inline constexpr Char_Class_Table char_classes{};
+
+    constexpr bool has_class(const char c, const std::uint8_t cls) {
+        return (char_classes.classes[static_cast<unsigned char>(c)] & cls) != 0;
+    }
+
+    constexpr bool is_space(const char c) { return has_class(c, cc_space); }
+    constexpr bool is_digit(const char c) { return has_class(c, cc_digit); }
+    constexpr bool is_alpha(const char c) { return has_class(c, cc_alpha); }
+    constexpr bool is_ident_start(const char c) { return has_class(c, cc_ident_start); }
+    constexpr bool is_ident(const char c) { return has_class(c, cc_ident); }
+    constexpr char to_lower(const char c) { return is_alpha(c) ? static_cast<char>(c | 0x20) : c; }
+
+    // -----------------------------------------------
+    //             Vectorized run scanners
+    // -----------------------------------------------
+
+    /// Scans `data[pos, end)` and returns the first position at which the run ends, or `end`
+    using Run_Scanner = std::size_t (*)(const char* data, std::size_t pos, std::size_t end);
+
+    enum class Scan_ISA {
+        scalar,
+        sse2,
+        avx2,
+    };
+
+    /// one implementation of every scanner the lexer hot loop uses
+    struct Char_Scanners {
+        Scan_ISA isa;
+        const char* name;
+        Run_Scanner skip_whitespace;    // end of a run of cc_space characters
+        Run_Scanner identifier_end;     // end of a run of cc_ident characters
+        Run_Scanner digit_end;          // end of a run of cc_digit characters
+        Run_Scanner find_newline;       // position of the next '\n'
+        Run_Scanner find_string_stop;   // position of the next '"' or '\\', where a string literal ends or escapes
+        Run_Scanner find_char_stop;     // position of the next '\'' or '\\', the same for a char literal
+    };
+
+    /// @returns the scanners for `isa`, or nullptr if this build or CPU does not support it
+    const Char_Scanners* get_scanners(Scan_ISA isa);
+
+    /// @returns the widest scanners the running CPU supports, resolved once on first use
+    const Char_Scanners& active_scanners();
+
+} // namespace udo::lexer
+
+#endif // CHAR_SCAN_HPP
@@ -7,49 +7,220 @@
 
 #include <istream>
 #include <string>
+#include <string_view>
+#include <cstdint>
 #include <vector>
-#include <map>
-#include <tuple>
+#include <array>
+#include <optional>
 #include <ranges>
 #include <support/global_constants.hpp>
+#include <support/source_manager.hpp>
+#include <error/diagid.hpp>
+#include <lexer/token_stream.hpp>
+#include <lexer/char_scan.hpp>
 
 namespace udo::lexer {
 
-    struct Token {
-        TokenType type;
-        std::string lexeme;
-        int line;
-        int column;
+    /// when tokenize() splits a buffer across threads
+    struct Parallel_Options {
+        std::size_t threshold = 4 << 20;    // buffers smaller than this are always lexed on the calling thread
+        std::size_t min_chunk = 1 << 20;    // no chunk is made smaller than this
+        unsigned max_threads = 0;           // 0 means std::thread::hardware_concurrency()
+    };
+
+    /// a single edit to a buffer: `removed` bytes at `offset` are replaced by `inserted`
+    struct Source_Edit {
+        std::size_t offset;
+        std::size_t removed;
+        std::string_view inserted;
+    };
 
-        TokenType get_type() const { return type; }
-        std::string get_lexeme() const { return lexeme; }
-        int get_line() const { return line; }
-        int get_column() const { return column; }
+    /// a diagnostic the lexer is holding on to until it can be reported, see Lexer::set_diagnostics
+    struct Lexer_Diagnostic {
+        Source_Location location;
+        diag::DiagID id;
     };
 
+    /// the window of the token stream an incremental re-lex replaced
+    struct Relex_Result {
+        std::size_t first_token;        // index of the first replaced token
+        std::size_t removed_tokens;     // number of tokens of the old stream that were dropped
+        std::size_t inserted_tokens;    // number of freshly lexed tokens in their place
+        std::vector<Lexer_Diagnostic> diagnostics;  // found in the fresh tokens, when no engine was given
+    };
 
-    class Lexer {
+    /// the text between the quotes of a string or char literal lexeme, which may lack its closing quote
+    constexpr std::string_view string_contents(const std::string_view lexeme) {
+        if (lexeme.size() < 2 || lexeme.back() != lexeme.front()) return lexeme.substr(lexeme.empty() ? 0 : 1);
+        // an odd run of backslashes before the last quote escapes it, so the literal was never closed
+        std::size_t backslashes = 0;
+        for (std::size_t i = lexeme.size() - 1; i > 1 && lexeme[i - 1] == '\\'; --i) ++backslashes;
+        return lexeme.substr(1, lexeme.size() - (backslashes % 2 == 0 ? 2 : 1));
+    }
+
+    /// Appends `contents` to `out` with its escape sequences decoded: \n \t \r \v \f \b \a \0 \\ \' \"
+    /// as in C, \xHH for a byte and \u{H...} for a code point, encoded as UTF-8. Invalid escapes are
+    /// copied through as written.
+    /// @returns the offset in `contents` of the first invalid escape sequence, or std::string_view::npos
+    std::size_t decode_escapes(std::string_view contents, std::string &out);
+
+    class Lexer final : public TokenSource {
     public:
+        /// number of tokens `peek` can look ahead, the streaming interface never holds more than this
+        static constexpr std::size_t max_lookahead = 16;
+
+        /// Reads the whole stream once into a buffer owned by the lexer, token lexemes
+        /// view into that buffer and are only valid for as long as the lexer is.
         explicit Lexer(std::istream &input_stream);
 
-        std::tuple<std::vector<Token>, std::vector<Token>, std::map<int, std::string>> tokenize();
+        /// Lexes directly over the contents of a Source_Manager buffer without copying them,
+        /// token lexemes view into `buffer.text()` and are valid for as long as the buffer is.
+        explicit Lexer(const Buffer &buffer, FileID file = 0);
+
+        /// Lex the whole source in one go, restarting from the beginning of the buffer.
+        /// Line text is not copied out, use Buffer::get_line_text on `get_buffer()`.
+        ///
+        /// Large buffers are split at line boundaries into chunks that are lexed on worker threads
+        /// and stitched back together, the result is identical to lexing them in one piece.
+        TokenStream tokenize();
+
+        /// Same as tokenize(), but also records the trivia before every token into `trivia`,
+        /// so that tokens and trivia together cover the source byte for byte.
+        TokenStream tokenize(Trivia_Table &trivia);
+
+        // streaming interface: tokens are lexed on demand into a ring of `max_lookahead` slots, so
+        // memory stays constant no matter how large the buffer is. Comments are left out, it is what
+        // the parser reads; tokenize() keeps them
+
+        Token next_token() override;
+        /// @param n must be less than `max_lookahead`
+        Token peek(std::size_t n = 0) override;
+        Token previous() const override { return last_token; }
+        const Numeric_Literal* literal(const Token &token) const override;
+        const std::string_view* decoded_string(const Token &token) const override;
+
+        /// rewind the streaming interface to the start of the buffer
+        void reset();
+
+        /// Apply `edit` to `buffer` and bring `tokens` (and `trivia`, if given), previously lexed from
+        /// `buffer` by tokenize(), up to date by re-lexing only the lines the edit touches.
+        ///
+        /// Lexing never carries state across a newline, so re-lexing starts at the beginning of the line
+        /// the edit starts on and resynchronizes with the old stream at the first newline past the
+        /// inserted text. Lexers and lexemes viewing into `buffer` are invalidated. Token locations keep
+        /// counting from the start of the buffer's slice of the Source_Manager's offset space, so an edit
+        /// that would grow the buffer past its slice is refused; set an overlay and load the file again
+        /// instead. Pass the same `identifiers` table and string storage the stream was lexed with, if any.
+        /// Errors in the fresh tokens are reported to `diagnostics`, or handed back in the result without one.
+        /// @returns std::nullopt, with `buffer` and `tokens` left alone, if the edit does not fit the slice
+        static std::optional<Relex_Result> relex(Buffer &buffer, FileID file, TokenStream &tokens, const Source_Edit &edit,
+                                  Trivia_Table *trivia = nullptr, IdentifierTable *identifiers = nullptr,
+                                  const String_Storage &strings = {}, diag::DiagnosticsEngine *diagnostics = nullptr);
+
+        /// intern every identifier into `table` as it is lexed, so tokens carry an IdentifierInfo*
+        void set_identifier_table(IdentifierTable *table) { identifiers = table; }
+        [[nodiscard]] IdentifierTable* get_identifier_table() const { return identifiers; }
+
+        /// decode string and char literals with escape sequences into `storage` as they are lexed
+        void set_string_storage(const String_Storage &storage) { strings = storage; }
+        [[nodiscard]] const String_Storage& get_string_storage() const { return strings; }
+
+        /// Report lexing errors to `engine` as they are found, which must only be used from the thread
+        /// doing the lexing. Without an engine they are held back until flush_diagnostics().
+        void set_diagnostics(diag::DiagnosticsEngine *engine) { diagnostics = engine; }
+        /// report and forget every diagnostic held back so far
+        void flush_diagnostics(diag::DiagnosticsEngine &engine);
+        [[nodiscard]] const std::vector<Lexer_Diagnostic>& get_pending_diagnostics() const { return pending_diagnostics; }
+
+        /// lex with `isa_scanners` instead of the widest ones the CPU supports, e.g. to compare them
+        void set_scanners(const Char_Scanners &isa_scanners) { scanners = &isa_scanners; }
+        [[nodiscard]] const Char_Scanners& get_scanners() const { return *scanners; }
+
+        void set_parallel_options(const Parallel_Options &options) { parallel = options; }
+        [[nodiscard]] const Parallel_Options& get_parallel_options() const { return parallel; }
+
+        [[nodiscard]] FileID get_file_id() const { return file; }
+        [[nodiscard]] std::string_view get_source() const { return source; }
+        [[nodiscard]] const Buffer& get_buffer() const { return *buffer; }
 
     private:
-        std::istream &input;
-        std::string current_line;
+        Buffer owned_buffer;                // only populated when lexing from a stream
+        const Buffer* buffer;
+        std::string_view source;
+        FileID file = 0;
+        const Char_Scanners* scanners;      // widest SIMD scanners the CPU supports, unless set otherwise
+        Parallel_Options parallel;
+        IdentifierTable* identifiers = nullptr;
+        String_Storage strings;
+        diag::DiagnosticsEngine* diagnostics = nullptr;
+        std::vector<Lexer_Diagnostic> pending_diagnostics;
+        std::string_view current_line;
         std::size_t current_pos;
-        int line_number;
-        std::map<int, std::string> unfiltered_lines;
-        const std::vector<std::string>& symbols;
-        std::string spaces;
-        std::vector<Token> unfiltered_tokens;
-
-        Token tokenize_number();
-        Token tokenize_identifier();
-        Token tokenize_symbol();
+        std::size_t trivia_start;           // start of the whitespace run preceding the last lexed token
+        std::size_t next_line_start = 0;
+        std::size_t range_end = 0;          // lexing stops here, the end of the source unless lexing a chunk
+        std::size_t line_end = 0;           // offset of the current line's '\n', or the end of the source
+        bool in_line = false;
+
+        Numeric_Literal decoded_literal;    // value of the last numeric literal tokenize_number accepted
+        bool string_escaped = false;        // the last string or char literal had escape sequences,
+        std::string_view escaped_string;    // decoded into this view of `strings` (a null view without storage)
+        std::string escape_scratch;
+
+        std::array<Token, max_lookahead> lookahead{};
+        std::array<Numeric_Literal, max_lookahead> lookahead_literals{};
+        std::array<std::string_view, max_lookahead> lookahead_strings{};
+        std::size_t lookahead_head = 0;
+        std::size_t lookahead_count = 0;
+        Token last_token;
+        Numeric_Literal last_literal;
+        std::string_view last_string;
+
+        [[nodiscard]] std::uint32_t offset_of(const char *p) const { return static_cast<std::uint32_t>(p - source.data()); }
+        /// the global location of `offset` into the buffer, see Source_Manager
+        [[nodiscard]] Source_Location location_of(const std::size_t offset) const {
+            return Source_Location(static_cast<Offset>(buffer->start + offset));
+        }
+
+        /// lex the token following the last one, with its location filled in
+        Token lex_token();
+        /// lex_token, skipping over comments
+        Token lex_significant_token();
+        /// push a token lexed by lex_token, along with the trivia before it when `trivia` is given
+        void append_token(TokenStream &tokens, Trivia_Table *trivia, const Token &token) const;
+        TokenStream lex_all(Trivia_Table *trivia);
+        /// Lex the lines in [begin, end), which must start at a line boundary, the eof token is
+        /// only produced when the end of the source is reached. A block comment still open at `end`
+        /// is followed to its end and the rest of its last line is lexed too.
+        /// @returns where lexing actually stopped, `end` unless a block comment ran past it
+        std::size_t lex_range(std::size_t begin, std::size_t end, TokenStream &tokens, Trivia_Table *trivia);
+        [[nodiscard]] std::vector<std::size_t> chunk_boundaries() const;
+
+        /// what the helpers below lex, lex_token makes it a Token located where the lexeme sits in the source
+        struct Lexeme {
+            TokenType type;
+            std::string_view text;
+        };
+
+        Lexeme tokenize_number();
+        Lexeme tokenize_identifier();
+        Lexeme tokenize_symbol();
+        /// string or char literal, which never runs past the end of its line
+        Lexeme tokenize_quoted(char quote);
+        /// `//` comment up to the end of the line, or `/* */` comment spanning as many lines as it needs
+        Lexeme tokenize_comment();
+        /// move the line state onto the line containing offset `pos`, which becomes the current position
+        void continue_at(std::size_t pos);
+        void report(std::size_t offset, diag::DiagID id);
         [[nodiscard]] bool is_symbol_start(char c) const;
+        static constexpr bool is_numeric_literal(const TokenType type) {
+            return type == TokenType::int_literal || type == TokenType::float_literal;
+        }
+        static constexpr bool is_quoted_literal(const TokenType type) {
+            return type == TokenType::string_literal || type == TokenType::char_literal;
+        }
     };
 
 } // namespace udo::lexer
 
-#endif // LEXER_HPP
\ No newline at end of file
+#endif // LEXER_HPP
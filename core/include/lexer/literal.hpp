@@ -0,0 +1,81 @@
+//
+// Created by David Yang on 2026-03-09.
+//
+
+#ifndef LITERAL_HPP
+#define LITERAL_HPP
+
+#include <cstdint>
+#include <string_view>
+#include <lexer/token_side_table.hpp>
+
+namespace udo::lexer {
+
+    /// Unsigned 128-bit integer, wide enough for every integer literal up to u128/i128.
+    struct Wide_Integer {
+        std::uint64_t low = 0;
+        std::uint64_t high = 0;
+
+        /// value = value * base + digit
+        /// @returns false if the result no longer fits in 128 bits
+        constexpr bool mul_add(const std::uint32_t base, const std::uint32_t digit) {
+            // four 32-bit limbs, so every partial product fits in 64 bits for any base <= 16
+            std::uint32_t limbs[4] = {
+                static_cast<std::uint32_t>(low), static_cast<std::uint32_t>(low >> 32),
+                static_cast<std::uint32_t>(high), static_cast<std::uint32_t>(high >> 32),
+            };
+            std::uint64_t carry = digit;
+            for (std::uint32_t& limb : limbs) {
+                const std::uint64_t product = static_cast<std::uint64_t>(limb) * base + carry;
+                limb = static_cast<std::uint32_t>(product);
+                carry = product >> 32;
+            }
+            low = limbs[0] | static_cast<std::uint64_t>(limbs[1]) << 32;
+            high = limbs[2] | static_cast<std::uint64_t>(limbs[3]) << 32;
+            return carry == 0;
+        }
+
+        [[nodiscard]] constexpr bool fits_u64() const { return high == 0; }
+
+        constexpr bool operator==(const Wide_Integer&) const = default;
+    };
+
+    /// one flag per letter group a numeric suffix is made of, e.g. `ull` is ls_unsigned | ls_long_long
+    /// and `lf` on a float is ls_long | ls_float
+    enum Literal_Suffix : std::uint8_t {
+        ls_none         = 0,
+        ls_unsigned     = 1 << 0,   // u
+        ls_long         = 1 << 1,   // l
+        ls_long_long    = 1 << 2,   // ll
+        ls_size         = 1 << 3,   // z
+        ls_float        = 1 << 4,   // f
+    };
+
+    /// Value of an int_literal or float_literal token, decoded by the lexer while it scans the token.
+    struct Numeric_Literal {
+        Wide_Integer integer;       // int_literal value
+        double floating = 0;        // float_literal value, rounded to nearest
+        std::uint8_t base = 10;     // 2, 8, 10 or 16
+        std::uint8_t suffix = ls_none;
+        bool is_float = false;
+        bool out_of_range = false;  // integer wider than 128 bits, or float over/underflowing a double
+    };
+
+    /// decoded numeric literals of a TokenStream, keyed by token index
+    using Literal_Table = Token_Side_Table<Numeric_Literal>;
+
+    /// Where the lexer keeps the decoded contents of string and char literals with escape sequences,
+    /// usually ASTContext::allocate_string. Literals without escapes are never copied.
+    struct String_Storage {
+        /// copies `decoded` into `arena`, the copy must outlive every token stream referring to it
+        using Store_Fn = const char* (*)(void* arena, std::string_view decoded);
+
+        void* arena = nullptr;
+        Store_Fn store = nullptr;
+
+        [[nodiscard]] explicit operator bool() const { return store != nullptr; }
+    };
+
+} // namespace udo::lexer
+
+#endif // LITERAL_HPP
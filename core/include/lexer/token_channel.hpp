@@ -0,0 +1,149 @@
+//
+// Created by David Yang on 2026-03-13.
+//
+
+#ifndef TOKEN_CHANNEL_HPP
+#define TOKEN_CHANNEL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <support/global_constants.hpp>
+#include <lexer/token_stream.hpp>
+
+namespace udo::lexer {
+
+    /// Lock-free single-producer/single-consumer ring of tokens, so the lexer can run on one thread
+    /// while the parser consumes its tokens on another.
+    ///
+    /// The producer side is produce_from(), normally handed the Lexer; the consumer side is the
+    /// TokenSource interface the parser already reads through. Each side only re-reads the other
+    /// side's position once its cached copy runs out, so the shared cache lines move rarely.
+    class Token_Channel final : public TokenSource {
+    public:
+        static constexpr std::size_t capacity = 4096;       // tokens in flight, power of two
+        static constexpr std::size_t max_lookahead = 16;    // how far the consumer may peek
+
+        Token_Channel() : slots(std::make_unique<Slot[]>(capacity)) {}
+
+        Token_Channel(const Token_Channel&) = delete;
+        Token_Channel& operator=(const Token_Channel&) = delete;
+
+        // ---- producer side ----
+
+        /// Pull every token out of `source` into the channel, up to and including eof, blocking
+        /// while the channel is full. Returns early if the consumer cancels.
+        void produce_from(TokenSource& source) {
+            for (;;) {
+                const Token token = source.next_token();
+                if (!push(token, source.literal(token), source.decoded_string(token))) return;
+                if (token.type == TokenType::eof) return;
+            }
+        }
+
+        /// publish one token, blocking while the channel is full
+        /// @returns false if the consumer cancelled and the token was dropped
+        bool push(const Token& token, const Numeric_Literal* literal, const std::string_view* decoded = nullptr) {
+            const std::size_t write = write_pos.load(std::memory_order_relaxed);
+            while (write - producer_read >= capacity) {
+                producer_read = read_pos.load(std::memory_order_acquire);
+                if (write - producer_read < capacity) break;
+                if (cancelled.load(std::memory_order_relaxed)) return false;
+                std::this_thread::yield();
+            }
+
+            Slot& slot = slots[write & (capacity - 1)];
+            slot.token = token;
+            slot.has_literal = literal != nullptr;
+            if (literal) slot.literal = *literal;
+            slot.decoded = decoded ? *decoded : std::string_view{};
+            write_pos.store(write + 1, std::memory_order_release);
+            return true;
+        }
+
+        // ---- consumer side ----
+
+        /// stop the producer, e.g. when parsing gives up before eof
+        void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+        Token next_token() override {
+            const std::size_t read = read_pos.load(std::memory_order_relaxed);
+            if (!wait_for(read, 1)) return last_slot.token;     // eof was consumed already, repeat it
+
+            last_slot = slots[read & (capacity - 1)];
+            read_pos.store(read + 1, std::memory_order_release);
+            return last_slot.token;
+        }
+
+        /// @param n must be less than `max_lookahead`
+        Token peek(const std::size_t n = 0) override {
+            const std::size_t read = read_pos.load(std::memory_order_relaxed);
+            if (!wait_for(read, n + 1)) {
+                // everything up to eof is already here, anything past it is eof again
+                return consumer_write > read ? slots[(consumer_write - 1) & (capacity - 1)].token : last_slot.token;
+            }
+            return slots[(read + n) & (capacity - 1)].token;
+        }
+
+        Token previous() const override { return last_slot.token; }
+
+        const Numeric_Literal* literal(const Token& token) const override {
+            if (token.type != TokenType::int_literal && token.type != TokenType::float_literal) return nullptr;
+            const Slot* slot = find(token);
+            return slot && slot->has_literal ? &slot->literal : nullptr;
+        }
+
+        const std::string_view* decoded_string(const Token& token) const override {
+            if (token.type != TokenType::string_literal && token.type != TokenType::char_literal) return nullptr;
+            const Slot* slot = find(token);
+            return slot && slot->decoded.data() ? &slot->decoded : nullptr;
+        }
+
+    private:
+        struct Slot {
+            Token token;
+            Numeric_Literal literal;
+            bool has_literal = false;
+            std::string_view decoded;   // null unless the token is an escaped literal the source decoded
+        };
+
+        /// the consumed token or one in the lookahead window that `token` is
+        const Slot* find(const Token& token) const {
+            if (last_slot.token.location == token.location) return &last_slot;
+            const std::size_t read = read_pos.load(std::memory_order_relaxed);
+            for (std::size_t i = read; i < consumer_write && i - read < max_lookahead; ++i) {
+                const Slot& slot = slots[i & (capacity - 1)];
+                if (slot.token.location == token.location) return &slot;
+            }
+            return nullptr;
+        }
+
+        /// wait until `count` tokens past `read` are published
+        /// @returns false if the stream ends (with eof) before that many tokens arrive
+        bool wait_for(const std::size_t read, const std::size_t count) {
+            while (consumer_write - read < count) {
+                if (consumer_write > read && slots[(consumer_write - 1) & (capacity - 1)].token.type == TokenType::eof) return false;
+                if (consumer_write == read && last_slot.token.type == TokenType::eof) return false;
+
+                const std::size_t published = write_pos.load(std::memory_order_acquire);
+                if (published == consumer_write) std::this_thread::yield();
+                consumer_write = published;
+            }
+            return true;
+        }
+
+        std::unique_ptr<Slot[]> slots;
+
+        // each side's position, and its cached copy of the other side's, sit on cache lines of their own
+        alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> write_pos{0};
+        std::size_t producer_read = 0;
+        alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> read_pos{0};
+        std::size_t consumer_write = 0;
+        Slot last_slot;
+        alignas(CACHE_LINE_SIZE) std::atomic<bool> cancelled{false};
+    };
+
+} // namespace udo::lexer
+
+#endif // TOKEN_CHANNEL_HPP
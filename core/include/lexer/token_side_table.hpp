@@ -0,0 +1,81 @@
+//
+// Created by David Yang on 2026-03-11.
+//
+
+#ifndef TOKEN_SIDE_TABLE_HPP
+#define TOKEN_SIDE_TABLE_HPP
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+namespace udo::lexer {
+
+    /// Per-token data that only some tokens carry (literal values, identifiers), kept out of the
+    /// TokenStream's arrays and keyed by token index so tokens without it cost nothing.
+    template <typename T>
+    class Token_Side_Table {
+        std::vector<std::uint32_t> token_indices;
+        std::vector<T> values;
+
+        [[nodiscard]] std::size_t bound(const std::uint32_t token_idx) const {
+            return static_cast<std::size_t>(std::lower_bound(token_indices.begin(), token_indices.end(), token_idx) - token_indices.begin());
+        }
+
+    public:
+        /// entries must be pushed in token order
+        void push(const std::uint32_t token_idx, const T& value) {
+            token_indices.push_back(token_idx);
+            values.push_back(value);
+        }
+
+        /// @returns the entry of token `token_idx`, or nullptr if it has none
+        [[nodiscard]] const T* find(const std::uint32_t token_idx) const {
+            const std::size_t idx = bound(token_idx);
+            return idx < token_indices.size() && token_indices[idx] == token_idx ? &values[idx] : nullptr;
+        }
+
+        /// append the entries of `other`, shifting their token indices by `first_token`
+        void append(const Token_Side_Table& other, const std::uint32_t first_token) {
+            for (const std::uint32_t idx : other.token_indices) token_indices.push_back(idx + first_token);
+            values.insert(values.end(), other.values.begin(), other.values.end());
+        }
+
+        /// drop the entries of tokens [first, first + removed), insert the entries of `with` (whose
+        /// indices are relative to `first`) and renumber the rest, see TokenStream::replace
+        void replace(const std::uint32_t first, const std::uint32_t removed, const std::uint32_t inserted, const Token_Side_Table& with) {
+            const std::size_t begin = bound(first);
+            const std::size_t end = bound(first + removed);
+            token_indices.erase(token_indices.begin() + begin, token_indices.begin() + end);
+            values.erase(values.begin() + begin, values.begin() + end);
+
+            token_indices.insert(token_indices.begin() + begin, with.token_indices.begin(), with.token_indices.end());
+            values.insert(values.begin() + begin, with.values.begin(), with.values.end());
+            for (std::size_t i = begin; i < begin + with.size(); ++i) token_indices[i] += first;
+            for (std::size_t i = begin + with.size(); i < token_indices.size(); ++i) {
+                token_indices[i] = token_indices[i] - removed + inserted;
+            }
+        }
+
+        /// call `fn(token_idx, value)` on every entry, in token order
+        template <typename Fn>
+        void for_each(Fn&& fn) {
+            for (std::size_t i = 0; i < values.size(); ++i) fn(token_indices[i], values[i]);
+        }
+
+        void clear() {
+            token_indices.clear();
+            values.clear();
+        }
+
+        [[nodiscard]] std::size_t size() const { return token_indices.size(); }
+        [[nodiscard]] bool empty() const { return token_indices.empty(); }
+
+        [[nodiscard]] std::size_t memory_usage() const {
+            return token_indices.capacity() * sizeof(std::uint32_t) + values.capacity() * sizeof(T);
+        }
+    };
+
+} // namespace udo::lexer
+
+#endif // TOKEN_SIDE_TABLE_HPP
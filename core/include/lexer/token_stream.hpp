@@ -0,0 +1,380 @@
+//
+// Created by David Yang on 2026-03-02.
+//
+
+#ifndef TOKEN_STREAM_HPP
+#define TOKEN_STREAM_HPP
+
+#include <cassert>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <support/global_constants.hpp>
+#include <support/source_manager.hpp>
+#include <support/identifier_table.hpp>
+#include <lexer/literal.hpp>
+#include <lexer/token_side_table.hpp>
+
+namespace udo::lexer {
+
+    /// A token as handed out to consumers, materialized on demand from a TokenStream.
+    struct Token {
+        TokenType type = TokenType::invalid_token;
+        std::string_view lexeme;    // view into the lexed source, never owned by the token
+        Source_Location location;
+        const IdentifierInfo* identifier = nullptr;    // interned spelling of an identifier, if the lexer had a table
+
+        [[nodiscard]] const IdentifierInfo* get_identifier() const { return identifier; }
+
+        TokenType get_type() const { return type; }
+        std::string_view get_lexeme() const { return lexeme; }
+        Source_Location get_location() const { return location; }
+    };
+
+    /// Compact struct-of-arrays storage for a lexed buffer.
+    ///
+    /// Every token costs 9 bytes: a one byte kind and a 32-bit start offset and length, all relative
+    /// to the start of the buffer, whose global location is `base`. Lexemes are views into the buffer and line/column
+    /// pairs are only resolved through the buffer's line table when they are asked for (e.g. diagnostics).
+    class TokenStream {
+        std::vector<std::uint8_t> kinds;
+        std::vector<std::uint32_t> offsets;
+        std::vector<std::uint32_t> lengths;
+        Literal_Table literal_table;    // decoded values of the numeric literals, filled in by the lexer
+        Token_Side_Table<const IdentifierInfo*> identifier_table;  // only filled in when lexing with an IdentifierTable
+        Token_Side_Table<std::string_view> string_table;    // decoded string and char literals, only those with escapes
+        Source_Location base;
+        const Buffer* buffer = nullptr;
+
+    public:
+        TokenStream() = default;
+        TokenStream(const Buffer* buffer, Source_Location base) : base(base), buffer(buffer) {}
+
+        void reserve(const std::size_t n) {
+            kinds.reserve(n);
+            offsets.reserve(n);
+            lengths.reserve(n);
+        }
+
+        void push(const TokenType type, const std::uint32_t offset, const std::uint32_t length) {
+            kinds.push_back(static_cast<std::uint8_t>(type));
+            offsets.push_back(offset);
+            lengths.push_back(length);
+        }
+
+        /// attach the decoded value of the numeric literal that was pushed last
+        void push_literal(const Numeric_Literal& value) {
+            literal_table.push(static_cast<std::uint32_t>(kinds.size() - 1), value);
+        }
+
+        /// attach the interned spelling of the identifier that was pushed last
+        void push_identifier(const IdentifierInfo* info) {
+            identifier_table.push(static_cast<std::uint32_t>(kinds.size() - 1), info);
+        }
+
+        /// attach the decoded contents of the escaped string or char literal that was pushed last, a null
+        /// view marks one that still has to be decoded (see decode_pending_strings)
+        void push_string(const std::string_view decoded) {
+            string_table.push(static_cast<std::uint32_t>(kinds.size() - 1), decoded);
+        }
+
+        /// decode every escaped literal pushed with a null view, `decode` maps a token index to its contents
+        template <typename Decode>
+        void decode_pending_strings(Decode&& decode) {
+            string_table.for_each([&](const std::uint32_t idx, std::string_view& decoded) {
+                if (!decoded.data()) decoded = decode(idx);
+            });
+        }
+
+        /// append every token of `other`, which must be relative to the same base
+        void append(const TokenStream& other) {
+            literal_table.append(other.literal_table, static_cast<std::uint32_t>(kinds.size()));
+            identifier_table.append(other.identifier_table, static_cast<std::uint32_t>(kinds.size()));
+            string_table.append(other.string_table, static_cast<std::uint32_t>(kinds.size()));
+            kinds.insert(kinds.end(), other.kinds.begin(), other.kinds.end());
+            offsets.insert(offsets.end(), other.offsets.begin(), other.offsets.end());
+            lengths.insert(lengths.end(), other.lengths.begin(), other.lengths.end());
+        }
+
+        /// Replace tokens [first, first + count) with the tokens of `with`, and move every token
+        /// after them by `shift` bytes. Used to splice a re-lexed window into an existing stream.
+        void replace(const std::size_t first, const std::size_t count, const TokenStream& with, const std::int64_t shift) {
+            literal_table.replace(static_cast<std::uint32_t>(first), static_cast<std::uint32_t>(count),
+                                  static_cast<std::uint32_t>(with.size()), with.literal_table);
+            identifier_table.replace(static_cast<std::uint32_t>(first), static_cast<std::uint32_t>(count),
+                                     static_cast<std::uint32_t>(with.size()), with.identifier_table);
+            string_table.replace(static_cast<std::uint32_t>(first), static_cast<std::uint32_t>(count),
+                                 static_cast<std::uint32_t>(with.size()), with.string_table);
+            const auto splice = [&](auto& dst, const auto& src) {
+                dst.erase(dst.begin() + first, dst.begin() + first + count);
+                dst.insert(dst.begin() + first, src.begin(), src.end());
+            };
+            splice(kinds, with.kinds);
+            splice(offsets, with.offsets);
+            splice(lengths, with.lengths);
+            for (std::size_t i = first + with.size(); i < offsets.size(); ++i) {
+                offsets[i] = static_cast<std::uint32_t>(offsets[i] + shift);
+            }
+        }
+
+        void clear() {
+            kinds.clear();
+            offsets.clear();
+            lengths.clear();
+            literal_table.clear();
+            identifier_table.clear();
+            string_table.clear();
+        }
+
+        [[nodiscard]] std::size_t size() const { return kinds.size(); }
+        [[nodiscard]] bool empty() const { return kinds.empty(); }
+
+        [[nodiscard]] TokenType kind(const std::size_t idx) const { return static_cast<TokenType>(kinds[idx]); }
+        [[nodiscard]] std::uint32_t offset(const std::size_t idx) const { return offsets[idx]; }
+        [[nodiscard]] std::uint32_t length(const std::size_t idx) const { return lengths[idx]; }
+
+        /// index of the first token starting at or after `offset` (relative to the base)
+        [[nodiscard]] std::size_t lower_bound(const std::uint32_t offset) const {
+            return static_cast<std::size_t>(std::lower_bound(offsets.begin(), offsets.end(), offset) - offsets.begin());
+        }
+
+        /// raw kind array, for scans that only care about token kinds
+        [[nodiscard]] const std::uint8_t* kind_data() const { return kinds.data(); }
+
+        /// @returns the decoded value of token `idx`, or nullptr if it is not a numeric literal
+        [[nodiscard]] const Numeric_Literal* literal(const std::size_t idx) const {
+            return literal_table.find(static_cast<std::uint32_t>(idx));
+        }
+        [[nodiscard]] const Literal_Table& literals() const { return literal_table; }
+
+        /// @returns the interned spelling of token `idx`, or nullptr if it is not an identifier or the
+        /// stream was lexed without an IdentifierTable
+        [[nodiscard]] const IdentifierInfo* identifier(const std::size_t idx) const {
+            if (kind(idx) != TokenType::identifier) return nullptr;
+            const IdentifierInfo* const* info = identifier_table.find(static_cast<std::uint32_t>(idx));
+            return info ? *info : nullptr;
+        }
+
+        /// @returns the decoded contents of string or char literal `idx`, or nullptr if it has no escape
+        /// sequences (its contents are then just string_contents() of its lexeme) or was not decoded
+        [[nodiscard]] const std::string_view* decoded_string(const std::size_t idx) const {
+            const std::string_view* decoded = string_table.find(static_cast<std::uint32_t>(idx));
+            return decoded && decoded->data() ? decoded : nullptr;
+        }
+
+        [[nodiscard]] Source_Location get_base() const { return base; }
+        [[nodiscard]] const Buffer* get_buffer() const { return buffer; }
+
+        [[nodiscard]] std::string_view lexeme(const std::size_t idx) const {
+            if (!buffer) return {};
+            return buffer->text().substr(offsets[idx], lengths[idx]);
+        }
+
+        [[nodiscard]] Source_Location location(const std::size_t idx) const {
+            return Source_Location(base.offset + offsets[idx]);
+        }
+
+        /// Resolve the 1-based line and column of a token through the buffer's line table. Only for
+        /// buffers outside any Source_Manager: a managed buffer's line table is guarded by the manager's
+        /// lock and its contents may be evicted, so use the overload taking the manager for those.
+        [[nodiscard]] std::pair<Line, Column> line_column(const std::size_t idx) const {
+            if (!buffer) return {0, 0};
+            assert(buffer->slice_size == 0 && "buffer belongs to a Source_Manager, resolve through it");
+            return const_cast<Buffer*>(buffer)->get_line_column(offsets[idx]);
+        }
+
+        /// line and column of a token lexed from one of `sources`' buffers
+        [[nodiscard]] std::pair<Line, Column> line_column(const std::size_t idx, const Source_Manager &sources) const {
+            return sources.getLineColumn(location(idx));
+        }
+
+        [[nodiscard]] Token operator[](const std::size_t idx) const {
+            return {kind(idx), lexeme(idx), location(idx), identifier(idx)};
+        }
+
+        /// approximate heap footprint of the token arrays, used to keep an eye on token memory
+        [[nodiscard]] std::size_t memory_usage() const {
+            return kinds.capacity() * sizeof(std::uint8_t)
+                 + offsets.capacity() * sizeof(std::uint32_t)
+                 + lengths.capacity() * sizeof(std::uint32_t);
+        }
+
+        class const_iterator {
+            const TokenStream* stream = nullptr;
+            std::size_t idx = 0;
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Token;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = Token;
+
+            const_iterator() = default;
+            const_iterator(const TokenStream* stream, const std::size_t idx) : stream(stream), idx(idx) {}
+
+            Token operator*() const { return (*stream)[idx]; }
+            const_iterator& operator++() { ++idx; return *this; }
+            const_iterator operator++(int) { const_iterator tmp = *this; ++idx; return tmp; }
+            bool operator==(const const_iterator& other) const { return idx == other.idx; }
+            bool operator!=(const const_iterator& other) const { return idx != other.idx; }
+        };
+
+        [[nodiscard]] const_iterator begin() const { return {this, 0}; }
+        [[nodiscard]] const_iterator end() const { return {this, size()}; }
+    };
+
+    /// Side table of the trivia (whitespace between tokens) a TokenStream leaves out.
+    ///
+    /// Only filled in when asked for, e.g. by formatters or fix-its that need to reproduce the source
+    /// exactly. Each entry is an offset/length pair keyed by the index of the token it precedes, and
+    /// entries are appended in token order, so the trivia of a token is found by binary search.
+    class Trivia_Table {
+        std::vector<std::uint32_t> token_indices;
+        std::vector<std::uint32_t> offsets;
+        std::vector<std::uint32_t> lengths;
+
+    public:
+        void push(const std::uint32_t token_idx, const std::uint32_t offset, const std::uint32_t length) {
+            token_indices.push_back(token_idx);
+            offsets.push_back(offset);
+            lengths.push_back(length);
+        }
+
+        /// append the entries of `other`, shifting their token indices by `first_token`
+        void append(const Trivia_Table& other, const std::uint32_t first_token) {
+            for (const std::uint32_t idx : other.token_indices) token_indices.push_back(idx + first_token);
+            offsets.insert(offsets.end(), other.offsets.begin(), other.offsets.end());
+            lengths.insert(lengths.end(), other.lengths.begin(), other.lengths.end());
+        }
+
+        /// Counterpart of TokenStream::replace: drop the entries of tokens [first, first + removed), insert
+        /// the entries of `with` (whose indices are relative to `first`) and renumber and move the rest.
+        void replace(const std::uint32_t first, const std::uint32_t removed, const std::uint32_t inserted,
+                     const Trivia_Table& with, const std::int64_t shift) {
+            const auto [begin, end] = std::pair{leading_bound(first), leading_bound(first + removed)};
+            token_indices.erase(token_indices.begin() + begin, token_indices.begin() + end);
+            offsets.erase(offsets.begin() + begin, offsets.begin() + end);
+            lengths.erase(lengths.begin() + begin, lengths.begin() + end);
+
+            token_indices.insert(token_indices.begin() + begin, with.token_indices.begin(), with.token_indices.end());
+            offsets.insert(offsets.begin() + begin, with.offsets.begin(), with.offsets.end());
+            lengths.insert(lengths.begin() + begin, with.lengths.begin(), with.lengths.end());
+            for (std::size_t i = begin; i < begin + with.size(); ++i) token_indices[i] += first;
+
+            for (std::size_t i = begin + with.size(); i < token_indices.size(); ++i) {
+                token_indices[i] = token_indices[i] - removed + inserted;
+                offsets[i] = static_cast<std::uint32_t>(offsets[i] + shift);
+            }
+        }
+
+        void clear() {
+            token_indices.clear();
+            offsets.clear();
+            lengths.clear();
+        }
+
+        [[nodiscard]] std::size_t size() const { return token_indices.size(); }
+        [[nodiscard]] bool empty() const { return token_indices.empty(); }
+
+        [[nodiscard]] std::uint32_t token_index(const std::size_t idx) const { return token_indices[idx]; }
+        [[nodiscard]] std::uint32_t offset(const std::size_t idx) const { return offsets[idx]; }
+        [[nodiscard]] std::uint32_t length(const std::size_t idx) const { return lengths[idx]; }
+
+        /// @returns the [first, last) range of entries preceding token `token_idx`
+        [[nodiscard]] std::pair<std::size_t, std::size_t> leading(const std::uint32_t token_idx) const {
+            return {leading_bound(token_idx), leading_bound(token_idx + 1)};
+        }
+
+        /// index of the first entry belonging to token `token_idx` or any later token
+        [[nodiscard]] std::size_t leading_bound(const std::uint32_t token_idx) const {
+            return static_cast<std::size_t>(std::lower_bound(token_indices.begin(), token_indices.end(), token_idx) - token_indices.begin());
+        }
+
+        [[nodiscard]] std::size_t memory_usage() const {
+            return (token_indices.capacity() + offsets.capacity() + lengths.capacity()) * sizeof(std::uint32_t);
+        }
+    };
+
+    /// Pull interface the parser reads tokens through, so it can run straight off a Lexer
+    /// without the whole file being lexed up front, or replay an already lexed TokenStream.
+    /// Comments never come out of it, they are trivia as far as the parser is concerned.
+    class TokenSource {
+    public:
+        virtual ~TokenSource() = default;
+
+        /// consume and return the next token, once the end is reached eof is returned indefinitely
+        virtual Token next_token() = 0;
+        /// look `n` tokens past the next one without consuming anything, peek(0) is the next token
+        virtual Token peek(std::size_t n = 0) = 0;
+        /// the most recently consumed token, an invalid_token before anything was consumed
+        virtual Token previous() const = 0;
+        /// decoded value of a numeric literal that is still within reach (the previous token or one in
+        /// the lookahead window), nullptr for any other token
+        virtual const Numeric_Literal* literal(const Token& token) const = 0;
+        /// decoded contents of a string or char literal with escape sequences that is still within reach,
+        /// nullptr for any other token or if the source had nowhere to store them
+        virtual const std::string_view* decoded_string(const Token& token) const = 0;
+    };
+
+    /// TokenSource over an already materialized TokenStream, the stream must outlive the reader.
+    class TokenStream_Reader final : public TokenSource {
+        const TokenStream& stream;
+        std::size_t pos = 0;            // next token to hand out, never a comment
+        std::size_t last = 0;           // one past the token handed out last, 0 before the first
+
+        [[nodiscard]] Token at(const std::size_t idx) const {
+            if (idx < stream.size()) return stream[idx];
+            if (stream.empty()) return {TokenType::eof, {}, stream.get_base()};
+            return stream[stream.size() - 1];
+        }
+
+        /// first index from `idx` on that is not a comment
+        [[nodiscard]] std::size_t skip_comments(std::size_t idx) const {
+            while (idx < stream.size() && stream.kind(idx) == TokenType::comment) ++idx;
+            return idx;
+        }
+
+        [[nodiscard]] std::size_t index_of(const Token& token) const {
+            return stream.lower_bound(static_cast<std::uint32_t>(token.location.offset - stream.get_base().offset));
+        }
+
+    public:
+        explicit TokenStream_Reader(const TokenStream& stream) : stream(stream), pos(skip_comments(0)) {}
+
+        Token next_token() override {
+            Token token = at(pos);
+            if (pos < stream.size()) {
+                last = pos + 1;
+                pos = skip_comments(pos + 1);
+            }
+            return token;
+        }
+
+        Token peek(const std::size_t n = 0) override {
+            std::size_t idx = pos;
+            for (std::size_t i = 0; i < n && idx < stream.size(); ++i) idx = skip_comments(idx + 1);
+            return at(idx);
+        }
+
+        Token previous() const override { return last == 0 ? Token{} : stream[last - 1]; }
+
+        const Numeric_Literal* literal(const Token& token) const override {
+            const std::size_t idx = index_of(token);
+            return idx < stream.size() ? stream.literal(idx) : nullptr;
+        }
+
+        const std::string_view* decoded_string(const Token& token) const override {
+            const std::size_t idx = index_of(token);
+            return idx < stream.size() ? stream.decoded_string(idx) : nullptr;
+        }
+
+        [[nodiscard]] std::size_t position() const { return pos; }
+    };
+
+} // namespace udo::lexer
+
+#endif // TOKEN_STREAM_HPP
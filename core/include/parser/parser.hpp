@@ -28,7 +28,7 @@ namespace udo::parse {
 
     struct ParserSnapshot {
         int capped_pos;
-        const std::vector<Token>& tokens;
+        TokenSource& tokens;
     };
 
     /// bundles useful information regarding the token being matched
@@ -53,13 +53,14 @@ namespace udo::parse {
     private:
         diag::DiagnosticsEngine& diagnostics_;
         ASTContext& context_;
-        std::vector<Token> tokens;
+        TokenSource& tokens;    // pulled on demand, lookahead is bounded by the source
         Flags flags;
         ParserContext parser_context;
-        int pos = 0;
+        int pos = 0;            // number of tokens consumed so far
 
     public:
         // peek at the current token without consuming it, n=0 means current token, n=1 means next token, etc.
+        // n=-1 is the previously consumed token, nothing further back is kept
         Token peek(int n = 0) const;
         // previous, peek(-1) alias
         Token previous() const { return peek(-1); }
@@ -77,6 +78,12 @@ namespace udo::parse {
         /// alias for match(MatchToken&)
         Token attempt(MatchToken& token) { return match(token); }
 
+        /// @returns the interned name of an identifier token, nullptr for any other token
+        const IdentifierInfo* get_identifier(const Token& token);
+
+        /// @returns the contents of a string or char literal token with its escapes decoded
+        std::string_view get_string(const Token& token);
+
         // EOF/token stream check
         bool is_at_end() const;
 
@@ -97,7 +104,7 @@ namespace udo::parse {
         void parse_variable_decl();
 
 
-        explicit Parser(const std::vector<Token> &tokens, Flags flag, ASTContext &context, diag::DiagnosticsEngine& diag);
+        explicit Parser(TokenSource& tokens, Flags flag, ASTContext &context, diag::DiagnosticsEngine& diag);
         ~Parser() = default;
     };
 }
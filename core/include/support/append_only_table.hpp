@@ -0,0 +1,94 @@
+//
+// Created by David Yang on 2026-03-18.
+//
+
+#ifndef APPEND_ONLY_TABLE_HPP
+#define APPEND_ONLY_TABLE_HPP
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace udo {
+
+    /// Append-only table indexed from 0, whose elements never move once added, so references to them
+    /// stay valid for as long as the table lives.
+    ///
+    /// Elements live in chunks that double in size, the first holding 64. Appending takes external
+    /// synchronization (one appender at a time), reading any element below size() is lock-free from
+    /// any thread.
+    template<typename T>
+    class Append_Only_Table {
+    public:
+        Append_Only_Table() = default;
+        Append_Only_Table(const Append_Only_Table&) = delete;
+        Append_Only_Table& operator=(const Append_Only_Table&) = delete;
+
+        ~Append_Only_Table() {
+            const std::size_t n = count.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < n; ++i) std::destroy_at(&(*this)[i]);
+            for (std::size_t chunk = 0; chunk < max_chunks; ++chunk) {
+                if (T* storage = chunks[chunk].load(std::memory_order_relaxed)) {
+                    std::allocator<T>().deallocate(storage, chunk_capacity(chunk));
+                }
+            }
+        }
+
+        /// number of published elements, every index below it can be read
+        [[nodiscard]] std::size_t size() const { return count.load(std::memory_order_acquire); }
+
+        /// @param index must be below a size() this thread has seen
+        [[nodiscard]] T& operator[](const std::size_t index) {
+            const auto [chunk, slot] = locate(index);
+            return chunks[chunk].load(std::memory_order_acquire)[slot];
+        }
+        [[nodiscard]] const T& operator[](const std::size_t index) const {
+            const auto [chunk, slot] = locate(index);
+            return chunks[chunk].load(std::memory_order_acquire)[slot];
+        }
+
+        /// @returns the element at `index`, or nullptr if it has not been published
+        [[nodiscard]] T* find(const std::size_t index) { return index < size() ? &(*this)[index] : nullptr; }
+        [[nodiscard]] const T* find(const std::size_t index) const { return index < size() ? &(*this)[index] : nullptr; }
+
+        /// construct an element at the end and publish it, the caller must be the only appender
+        /// @returns its index
+        template<typename... Args>
+        std::size_t emplace_back(Args&&... args) {
+            const std::size_t index = count.load(std::memory_order_relaxed);
+            const auto [chunk, slot] = locate(index);
+            T* storage = chunks[chunk].load(std::memory_order_relaxed);
+            if (!storage) {
+                storage = std::allocator<T>().allocate(chunk_capacity(chunk));
+                chunks[chunk].store(storage, std::memory_order_release);
+            }
+            std::construct_at(storage + slot, std::forward<Args>(args)...);
+            count.store(index + 1, std::memory_order_release);
+            return index;
+        }
+
+    private:
+        static constexpr std::size_t first_chunk_bits = 6;
+        static constexpr std::size_t max_chunks = 32 - first_chunk_bits;  // room for every 32-bit index
+
+        static constexpr std::size_t chunk_capacity(const std::size_t chunk) {
+            return std::size_t{1} << (chunk + first_chunk_bits);
+        }
+
+        /// chunk k holds indices [64 * (2^k - 1), 64 * (2^(k+1) - 1))
+        static constexpr std::pair<std::size_t, std::size_t> locate(const std::size_t index) {
+            const std::size_t biased = index + chunk_capacity(0);
+            const std::size_t chunk = std::bit_width(biased) - 1 - first_chunk_bits;
+            return {chunk, biased - chunk_capacity(chunk)};
+        }
+
+        std::array<std::atomic<T*>, max_chunks> chunks{};
+        std::atomic<std::size_t> count{0};
+    };
+
+} // namespace udo
+
+#endif // APPEND_ONLY_TABLE_HPP
@@ -5,9 +5,12 @@
 #ifndef GLOBAL_CONSTANTS_HPP
 #define GLOBAL_CONSTANTS_HPP
 
+#include <cstdint>
 #include <string>
-#include <unordered_set>
+#include <string_view>
 #include <vector>
+#include <utility>
+#include <iterator>
 #include <algorithm>
 #include <ranges>
 
@@ -38,37 +41,28 @@
 
 namespace udo::lexer {
 
-    enum class TokenType {
+    // Every keyword, spelled exactly as its TokenType without the `kw_` prefix. Both the TokenType
+    // enumerators and the keyword lookup table are generated from this one list, so adding a keyword
+    // here is all it takes for the lexer to recognise it.
+    #define UDO_KEYWORDS(KEYWORD) \
+        KEYWORD(let) KEYWORD(as) KEYWORD(if) KEYWORD(else) KEYWORD(functor) KEYWORD(return) \
+        KEYWORD(i4) KEYWORD(i8) KEYWORD(i16) KEYWORD(i32) KEYWORD(i64) KEYWORD(i128) \
+        KEYWORD(f4) KEYWORD(f8) KEYWORD(f16) KEYWORD(f32) KEYWORD(f64) KEYWORD(f128) \
+        KEYWORD(char) KEYWORD(bool) KEYWORD(import) KEYWORD(mod) KEYWORD(export) KEYWORD(bind)
+
+    // kept to one byte so TokenStream can store kinds in a dense uint8_t array
+    enum class TokenType : std::uint8_t {
         // Keywords
-        kw_let,
-        kw_as,
-        kw_if,
-        kw_else,
-        kw_functor,
-        kw_return,
-        kw_i4,
-        kw_i8,
-        kw_i16,
-        kw_i32,
-        kw_i64,
-        kw_i128,
-        kw_f4,
-        kw_f8,
-        kw_f16,
-        kw_f32,
-        kw_f64,
-        kw_f128,
-        kw_char,
-        kw_bool,
-        kw_import,
-        kw_mod,
-        kw_export,
-        kw_bind,
+        #define UDO_KEYWORD_ENUMERATOR(name) kw_##name,
+        UDO_KEYWORDS(UDO_KEYWORD_ENUMERATOR)
+        #undef UDO_KEYWORD_ENUMERATOR
 
         // Identifiers and Literals
         identifier,
         int_literal,
         float_literal,
+        string_literal,
+        char_literal,
         number,
 
         // Special
@@ -108,102 +102,231 @@ namespace udo::lexer {
         invalid_token,
     };
 
-    // Keyword set for fast lookup
-    inline const std::unordered_set<std::string> keywords = {
-        "let", "as", "if", "else",
-        "functor", "return", "i4",
-        "i8", "i16", "i32", "i64", "i128",
-        "f4", "f8", "f16", "f32", "f64", "f128",
-        "char", "bool", "import", "mod", "export",
-        "bind"
+    // A keyword spelling and the TokenType it lexes to
+    struct Keyword_Spelling {
+        std::string_view spelling;
+        TokenType type;
+    };
+
+    inline constexpr Keyword_Spelling keyword_spellings[] = {
+        #define UDO_KEYWORD_SPELLING(name) {#name, TokenType::kw_##name},
+        UDO_KEYWORDS(UDO_KEYWORD_SPELLING)
+        #undef UDO_KEYWORD_SPELLING
     };
 
+    namespace detail {
+
+        // The hash key packs the length and the first, second and last characters of a spelling,
+        // which is enough to tell every keyword apart (checked below) without touching the rest of it.
+        constexpr std::uint32_t keyword_key(const std::string_view str) {
+            return static_cast<std::uint32_t>(str.size()) << 24
+                 | static_cast<std::uint32_t>(static_cast<unsigned char>(str.front())) << 16
+                 | static_cast<std::uint32_t>(static_cast<unsigned char>(str[1])) << 8
+                 | static_cast<std::uint32_t>(static_cast<unsigned char>(str.back()));
+        }
+
+        inline constexpr std::size_t keyword_table_bits = 6;
+        inline constexpr std::size_t keyword_table_size = std::size_t{1} << keyword_table_bits;
+        static_assert(std::size(keyword_spellings) <= keyword_table_size / 2, "grow keyword_table_bits");
+
+        constexpr std::size_t keyword_slot(const std::uint32_t key, const std::uint32_t seed) {
+            return (key * seed) >> (32 - keyword_table_bits);
+        }
+
+        consteval std::size_t min_keyword_length() {
+            std::size_t len = keyword_spellings[0].spelling.size();
+            for (const auto &[spelling, type] : keyword_spellings) len = std::min(len, spelling.size());
+            return len;
+        }
+
+        consteval std::size_t max_keyword_length() {
+            std::size_t len = 0;
+            for (const auto &[spelling, type] : keyword_spellings) len = std::max(len, spelling.size());
+            return len;
+        }
+
+        static_assert(min_keyword_length() >= 2, "keyword_key() reads the second character");
+
+        // search for a multiplicative seed under which no two keywords share a slot
+        consteval std::uint32_t find_keyword_seed() {
+            for (std::uint32_t seed = 0x9E3779B1u; ; seed += 2) {
+                bool used[keyword_table_size] = {};
+                bool collision = false;
+                for (const auto &[spelling, type] : keyword_spellings) {
+                    const std::size_t slot = keyword_slot(keyword_key(spelling), seed);
+                    if (used[slot]) {
+                        collision = true;
+                        break;
+                    }
+                    used[slot] = true;
+                }
+                if (!collision) return seed;
+            }
+        }
+
+        /// Perfect hash table of the keywords, an empty spelling marks an unused slot
+        struct Keyword_Table {
+            std::uint32_t seed = find_keyword_seed();
+            Keyword_Spelling slots[keyword_table_size] = {};
+
+            consteval Keyword_Table() {
+                for (const auto &keyword : keyword_spellings) {
+                    slots[keyword_slot(keyword_key(keyword.spelling), seed)] = keyword;
+                }
+            }
+
+            [[nodiscard]] constexpr const Keyword_Spelling* find(const std::string_view str) const {
+                if (str.size() < min_keyword_length() || str.size() > max_keyword_length()) return nullptr;
+                const Keyword_Spelling &slot = slots[keyword_slot(keyword_key(str), seed)];
+                return slot.spelling == str ? &slot : nullptr;
+            }
+        };
+
+    } // namespace detail
+
+    inline constexpr detail::Keyword_Table keyword_table{};
+
     // Check if a string is a keyword
-    inline bool is_keyword(const std::string &str) {
-        return keywords.contains(str);
+    constexpr bool is_keyword(const std::string_view str) {
+        return keyword_table.find(str) != nullptr;
     }
 
-    // Get the TokenType for a keyword string
-    inline TokenType get_keyword_type(const std::string &str) {
-        if (str == "let") return TokenType::kw_let;
-        if (str == "as") return TokenType::kw_as;
-        if (str == "if") return TokenType::kw_if;
-        if (str == "else") return TokenType::kw_else;
-        if (str == "functor") return TokenType::kw_functor;
-        if (str == "return") return TokenType::kw_return;
-        if (str == "i4") return TokenType::kw_i4;
-        if (str == "i8") return TokenType::kw_i8;
-        if (str == "i16") return TokenType::kw_i16;
-        if (str == "i32") return TokenType::kw_i32;
-        if (str == "i64") return TokenType::kw_i64;
-        if (str == "i128") return TokenType::kw_i128;
-        if (str == "f4") return TokenType::kw_f4;
-        if (str == "f8") return TokenType::kw_f8;
-        if (str == "f16") return TokenType::kw_f16;
-        if (str == "f32") return TokenType::kw_f32;
-        if (str == "f64") return TokenType::kw_f64;
-        if (str == "f128") return TokenType::kw_f128;
-        if (str == "char") return TokenType::kw_char;
-        if (str == "bool") return TokenType::kw_bool;
-        if (str == "import") return TokenType::kw_import;
-        if (str == "mod") return TokenType::kw_mod;
-        if (str == "export") return TokenType::kw_export;
-        if (str == "bind") return TokenType::kw_bind;
-        return TokenType::identifier; // fallback
+    // Get the TokenType for a keyword string, TokenType::identifier if it is not one
+    constexpr TokenType get_keyword_type(const std::string_view str) {
+        const Keyword_Spelling* keyword = keyword_table.find(str);
+        return keyword ? keyword->type : TokenType::identifier;
     }
 
-    // Get the TokenType for a symbol string
-    inline TokenType get_symbol_type(const std::string &str) {
-        if (str == "=") return TokenType::equal;
-        if (str == ";") return TokenType::semicolon;
-        if (str == "::") return TokenType::double_colon;
-        if (str == ",") return TokenType::comma;
-        if (str == ":") return TokenType::colon;
-        if (str == "{") return TokenType::lbrace;
-        if (str == "}") return TokenType::rbrace;
-        if (str == "[") return TokenType::lbracket;
-        if (str == "]") return TokenType::rbracket;
-        if (str == "(") return TokenType::lparen;
-        if (str == ")") return TokenType::rparen;
-        if (str == "+") return TokenType::plus;
-        if (str == "-") return TokenType::minus;
-        if (str == "*") return TokenType::star;
-        if (str == "/") return TokenType::slash;
-        if (str == "!") return TokenType::bang;
-        if (str == "!=") return TokenType::bang_equal;
-        if (str == "==") return TokenType::equal_equal;
-        if (str == "<") return TokenType::less;
-        if (str == "<=") return TokenType::less_equal;
-        if (str == ">") return TokenType::greater;
-        if (str == ">=") return TokenType::greater_equal;
-        if (str == "\\") return TokenType::comment;
-        if (str == ".") return TokenType::dot;
-        if (str == "..") return TokenType::double_dot;
-        if (str == "...") return TokenType::triple_dot;
-        return TokenType::unknown;
-    }
+    static_assert(get_keyword_type("let") == TokenType::kw_let);
+    static_assert(get_keyword_type("i128") == TokenType::kw_i128);
+    static_assert(get_keyword_type("functor") == TokenType::kw_functor);
+    static_assert(get_keyword_type("i12") == TokenType::identifier);
+
+    // A symbol spelling and the TokenType it lexes to
+    struct Symbol_Spelling {
+        std::string_view spelling;
+        TokenType type;
+    };
+
+    // Lexer symbol table, the single source for symbol matching and get_symbol_type().
+    // Spellings without a dedicated TokenType yet lex as TokenType::unknown. Quotes and escape sequences
+    // are not symbols, string and char literals (like `//` and `/*` comments) are scanned whole.
+    inline constexpr Symbol_Spelling symbol_spellings[] = {
+        {"<<@", TokenType::unknown}, {"...", TokenType::triple_dot},
+        {"==", TokenType::equal_equal}, {"!=", TokenType::bang_equal}, {"<=", TokenType::less_equal},
+        {">=", TokenType::greater_equal}, {"=>", TokenType::unknown}, {"->", TokenType::unknown},
+        {"::", TokenType::double_colon}, {"||", TokenType::unknown}, {"&&", TokenType::unknown},
+        {"+=", TokenType::unknown}, {"-=", TokenType::unknown}, {"<<", TokenType::unknown},
+        {">>", TokenType::unknown}, {"^+", TokenType::unknown}, {"^-", TokenType::unknown},
+        {"..", TokenType::double_dot},
+        {"=", TokenType::equal}, {"+", TokenType::plus}, {"-", TokenType::minus}, {"*", TokenType::star},
+        {"/", TokenType::slash}, {"(", TokenType::lparen}, {")", TokenType::rparen},
+        {"{", TokenType::lbrace}, {"}", TokenType::rbrace}, {"[", TokenType::lbracket},
+        {"]", TokenType::rbracket}, {";", TokenType::semicolon}, {",", TokenType::comma},
+        {":", TokenType::colon}, {"\\", TokenType::unknown}, {"@", TokenType::unknown}, {"#", TokenType::unknown},
+        {"$", TokenType::unknown}, {"%", TokenType::unknown}, {"&", TokenType::unknown},
+        {"?", TokenType::unknown}, {"!", TokenType::bang}, {"<", TokenType::less},
+        {">", TokenType::greater}, {"|", TokenType::unknown}, {"^", TokenType::unknown},
+        {"~", TokenType::unknown}, {".", TokenType::dot},
+    };
+
+    namespace detail {
+
+        // number of distinct characters used anywhere in the symbol table
+        consteval std::size_t count_symbol_chars() {
+            bool seen[256] = {};
+            std::size_t count = 0;
+            for (const auto &[spelling, type] : symbol_spellings) {
+                for (const char c : spelling) {
+                    if (!seen[static_cast<unsigned char>(c)]) {
+                        seen[static_cast<unsigned char>(c)] = true;
+                        ++count;
+                    }
+                }
+            }
+            return count;
+        }
+
+        // number of trie nodes, i.e. distinct non-empty prefixes plus the root
+        consteval std::size_t count_symbol_prefixes() {
+            std::size_t count = 1;
+            constexpr std::size_t n = std::size(symbol_spellings);
+            for (std::size_t i = 0; i < n; ++i) {
+                const std::string_view sym = symbol_spellings[i].spelling;
+                for (std::size_t len = 1; len <= sym.size(); ++len) {
+                    bool seen = false;
+                    for (std::size_t j = 0; j < i && !seen; ++j) {
+                        const std::string_view other = symbol_spellings[j].spelling;
+                        seen = other.size() >= len && other.substr(0, len) == sym.substr(0, len);
+                    }
+                    if (!seen) ++count;
+                }
+            }
+            return count;
+        }
+
+        /// Trie over the symbol table, flattened into a DFA transition table.
+        /// Characters are first folded into a dense class (0 means "not a symbol character") to keep
+        /// the table small, and state 0 is the root which is never a transition target, so a 0 entry
+        /// in `next` means there is no transition.
+        template <std::size_t States, std::size_t Classes>
+        struct Symbol_Trie {
+            static_assert(States < 256 && Classes < 256, "symbol trie no longer fits 8-bit states");
 
-    // Lexer symbols list (sorted by length descending for longest-match)
-    inline std::vector<std::string> get_symbols() {
-        std::vector<std::string> syms = {
-            "\\\"", "\\\'", "\\\t", "\\\n", "\\\r", "\\\v", "\\\f", "\\\b", "\\\a",
-            "<<@", "...", "==", "!=", "<=", ">=", "=>", "->", "::", "||", "&&",
-            "+=", "-=", "<<", ">>", "^+", "^-", "\\\\", "..",
-            "=", "+", "-", "*", "/", "(", ")", "{", "}", "[", "]", ";", ",", ":",
-            "\"", "\'", "\\", "@", "#", "$", "%", "&", "?", "!", "<", ">", "|", "^", "~", "."
+            std::uint8_t char_class[256] = {};
+            std::uint8_t next[States][Classes + 1] = {};
+            TokenType accept[States] = {};
+            bool accepting[States] = {};
+
+            consteval Symbol_Trie() {
+                std::size_t classes = 0;
+                std::size_t states = 1;
+                for (const auto &[spelling, type] : symbol_spellings) {
+                    std::size_t state = 0;
+                    for (const char c : spelling) {
+                        auto &cls = char_class[static_cast<unsigned char>(c)];
+                        if (cls == 0) cls = static_cast<std::uint8_t>(++classes);
+                        if (next[state][cls] == 0) next[state][cls] = static_cast<std::uint8_t>(states++);
+                        state = next[state][cls];
+                    }
+                    accept[state] = type;
+                    accepting[state] = true;
+                }
+            }
+
+            /// Longest symbol at the front of `text`.
+            /// @returns the symbol's TokenType and length, or a length of 0 if `text` does not start with a symbol
+            [[nodiscard]] constexpr std::pair<TokenType, std::size_t> longest_match(const std::string_view text) const {
+                std::pair<TokenType, std::size_t> best{TokenType::unknown, 0};
+                std::size_t state = 0;
+                for (std::size_t i = 0; i < text.size(); ++i) {
+                    state = next[state][char_class[static_cast<unsigned char>(text[i])]];
+                    if (state == 0) break;
+                    if (accepting[state]) best = {accept[state], i + 1};
+                }
+                return best;
+            }
+
+            [[nodiscard]] constexpr bool is_start(const char c) const {
+                return next[0][char_class[static_cast<unsigned char>(c)]] != 0;
+            }
         };
-        std::ranges::sort(syms, [](const std::string &a, const std::string &b) {
-            return a.size() > b.size();
-        });
-        return syms;
-    }
 
-    // Pre-sorted symbols constant (initialized once)
-    inline const std::vector<std::string>& symbols() {
-        static const std::vector<std::string> sorted_symbols = get_symbols();
-        return sorted_symbols;
+    } // namespace detail
+
+    inline constexpr detail::Symbol_Trie<detail::count_symbol_prefixes(), detail::count_symbol_chars()> symbol_trie{};
+
+    // Get the TokenType for a symbol string
+    constexpr TokenType get_symbol_type(const std::string_view str) {
+        const auto [type, length] = symbol_trie.longest_match(str);
+        return length == str.size() ? type : TokenType::unknown;
     }
 
+    static_assert(symbol_trie.longest_match("<<@x").second == 3);
+    static_assert(symbol_trie.longest_match("...").first == TokenType::triple_dot);
+    static_assert(symbol_trie.longest_match("::").first == TokenType::double_colon);
+    static_assert(get_symbol_type("..") == TokenType::double_dot);
+
 } // namespace udo::lexer
 
 #endif //GLOBAL_CONSTANTS_HPP
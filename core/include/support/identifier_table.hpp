@@ -0,0 +1,77 @@
+//
+// Created by David Yang on 2026-03-11.
+//
+
+#ifndef IDENTIFIER_TABLE_HPP
+#define IDENTIFIER_TABLE_HPP
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <type_traits>
+
+namespace udo {
+
+    /// A distinct identifier spelling, interned once per IdentifierTable.
+    ///
+    /// Two identifiers are the same name exactly when their IdentifierInfo pointers are equal,
+    /// so comparing and hashing names never has to look at the characters.
+    class IdentifierInfo {
+        friend class IdentifierTable;
+
+        const char* spelling;
+        std::uint32_t length;
+
+        IdentifierInfo(const char* spelling, const std::uint32_t length) : spelling(spelling), length(length) {}
+
+    public:
+        [[nodiscard]] std::string_view get_name() const { return {spelling, length}; }
+        [[nodiscard]] std::uint32_t size() const { return length; }
+    };
+    static_assert(std::is_trivially_destructible_v<IdentifierInfo>);
+
+    /// Interns identifier spellings into an arena, handing out one IdentifierInfo per spelling.
+    ///
+    /// Safe to intern from several threads at once: spellings are spread over independently locked
+    /// shards by hash, and the arena is only touched, under its own lock, when a new spelling is added.
+    /// That lock is private to the table, so the arena must not be allocated from by anything else.
+    class IdentifierTable {
+    public:
+        /// allocates `size` bytes aligned to `align` from `arena`, the memory must outlive the table
+        using Allocate_Fn = void* (*)(void* arena, std::size_t size, std::size_t align);
+
+        static constexpr std::size_t shard_count = 16;
+
+        IdentifierTable(void* arena, Allocate_Fn allocate) : arena(arena), allocate_fn(allocate) {}
+
+        IdentifierTable(const IdentifierTable&) = delete;
+        IdentifierTable& operator=(const IdentifierTable&) = delete;
+
+        /// @returns the IdentifierInfo for `name`, creating it on first use
+        const IdentifierInfo* get(std::string_view name);
+
+        /// @returns the IdentifierInfo for `name`, or nullptr if it was never interned
+        [[nodiscard]] const IdentifierInfo* find(std::string_view name) const;
+
+        /// number of distinct spellings interned so far
+        [[nodiscard]] std::size_t size() const;
+
+    private:
+        struct alignas(64) Shard {
+            mutable std::mutex mutex;
+            std::unordered_map<std::string_view, const IdentifierInfo*> names;  // keys view into the arena
+        };
+
+        void* arena;
+        Allocate_Fn allocate_fn;
+        std::mutex arena_mutex;
+        std::array<Shard, shard_count> shards;
+
+        static std::size_t shard_of(const std::size_t hash) { return (hash >> 7) % shard_count; }
+    };
+
+} // namespace udo
+
+#endif // IDENTIFIER_TABLE_HPP
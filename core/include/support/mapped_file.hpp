@@ -0,0 +1,45 @@
+//
+// Created by David Yang on 2026-03-16.
+//
+
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace udo {
+
+    /// A read-only, private memory mapping of a whole file, unmapped when it goes out of scope.
+    ///
+    /// Pages are faulted in on first access and the kernel is told the file will be read front to
+    /// back, so opening costs the same no matter how large the file is.
+    ///
+    /// Rewriting the file in place (rather than replacing it, as editors do) shows through the
+    /// mapping, and truncating it makes reads past the new end fault.
+    class Mapped_File {
+    public:
+        Mapped_File() = default;
+        ~Mapped_File();
+
+        Mapped_File(Mapped_File &&other) noexcept;
+        Mapped_File& operator=(Mapped_File &&other) noexcept;
+        Mapped_File(const Mapped_File&) = delete;
+        Mapped_File& operator=(const Mapped_File&) = delete;
+
+        /// Map the file at `path`. Empty files and platforms without mmap leave the result unmapped,
+        /// as does any failure to open or map the file, which callers tell apart by retrying a read.
+        static Mapped_File open(const std::string &path);
+
+        [[nodiscard]] std::string_view view() const { return {data, size}; }
+        [[nodiscard]] explicit operator bool() const { return data != nullptr; }
+
+    private:
+        const char* data = nullptr;
+        std::size_t size = 0;
+    };
+
+} // namespace udo
+
+#endif // MAPPED_FILE_HPP
@@ -8,10 +8,17 @@
 #include <ostream>
 #include <fstream>
 #include <vector>
+#include <list>
 #include <unordered_map>
 #include <cstdint>
-
-#define GET_COLUMN_FOR_BUFFER (data.empty() ? 1 : (data.size() - line_starts.back() + 1))
+#include <string_view>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <error/diagid.hpp>
+#include <support/append_only_table.hpp>
+#include <support/mapped_file.hpp>
 
 namespace udo::diag {
     struct Diagnostic;
@@ -25,20 +32,22 @@ namespace udo {
 
     // forward types
     using FileID = uint32_t;
-    using Offset = uint64_t;
+    using Offset = uint32_t;
 
+    /// A position in the single offset space the Source_Manager lays every buffer out in, each buffer
+    /// owning a contiguous slice of it. The file and the offset within it are recovered through
+    /// Source_Manager::get_file_id and get_file_offset. Offset 0 belongs to no file and is invalid.
     struct Source_Location {
-        FileID file = 0;
         Offset offset = 0;
 
         Source_Location() = default;
-        Source_Location(FileID f, Offset o) : file(f), offset(o) {}
+        explicit Source_Location(Offset o) : offset(o) {}
 
-        bool isValid() const { return file != 0 || offset != 0; }
+        bool isValid() const { return offset != 0; }
         bool isInvalid() const { return !isValid(); }
 
         bool operator==(const Source_Location& other) const {
-            return file == other.file && offset == other.offset;
+            return offset == other.offset;
         }
         bool operator!=(const Source_Location& other) const {
             return !(*this == other);
@@ -55,50 +64,214 @@ namespace udo {
         bool isValid() const { return begin.isValid() && end.isValid(); }
     };
 
-    inline Source_Location make_source_loc(FileID file, Offset offset) {
-        return Source_Location(file, offset);
-    }
-
-    inline FileID loc_to_FileID(Source_Location loc) {
-        return loc.file;
-    }
-
     inline Offset loc_to_Offset(Source_Location loc) {
         return loc.offset;
     }
 
+    /// Contents of a file loaded from disk, mapped where the platform allows it and read otherwise.
+    /// Buffers of files with identical contents share one.
+    struct File_Contents {
+        Mapped_File mapping;
+        std::string data;                           // used when the file could not be mapped
+
+        [[nodiscard]] std::string_view text() const { return mapping ? mapping.view() : std::string_view(data); }
+    };
+
     struct Buffer {
-        std::string data;                           // owned contents
+        std::string data;                           // owned contents, empty while the buffer views `contents`
+        std::shared_ptr<const File_Contents> contents;  // contents loaded from disk, possibly shared with other buffers
         std::string path;                           // path to the original file
-        std::vector<std::size_t> line_starts;       // offsets for start of each line (0-based)
+        std::vector<std::size_t> line_starts;       // offsets for start of each line (0-based), built on first use
         bool computed = false;                      // line starts computed
+        bool ascii = false;                         // no multi-byte UTF-8, so byte and code point columns agree
+        bool encoding_checked = false;              // `ascii` and validate_utf8() are up to date
+        Offset start = 0;                           // first global offset of the slice a Source_Manager gave it
+        std::size_t slice_size = 0;                 // length of that slice, 0 if no Source_Manager gave it one
+        std::size_t last_line = 0;                  // index of the line get_line_column resolved last
+        std::size_t hash = 0;                       // hash of the contents, set for buffers loaded from disk
+        bool on_disk = false;                       // contents are those of the file at `path`, so they can be read again
+        std::uint32_t uses = 0;                     // loads handed out and not released yet, see Source_Manager::release
+        bool released = false;                      // nothing views the contents any more, see Source_Manager::release
+        bool evicted = false;                       // contents and line table dropped until something asks for them
 
         Buffer() = default;
         Buffer(const std::string &data, const std::string &path);
 
+        /// the contents, whether they are owned or loaded from disk
+        [[nodiscard]] std::string_view text() const { return contents ? contents->text() : std::string_view(data); }
+        [[nodiscard]] bool is_mapped() const { return contents && contents->mapping; }
+
+        /// copy contents loaded from disk into `data` and let go of them, so they can be edited in place
+        /// without touching any other buffer sharing them
+        std::string& make_owned();
+
+        /// Build `line_starts` at its exact size, which line and column lookups do on demand, so a
+        /// buffer nobody reports a diagnostic against never pays for it.
         void compute_line_starts();
 
+        /// validates `data` as UTF-8 and records whether it is plain ASCII
+        /// @returns the offset of the first ill-formed byte, or data.size() if there is none
+        std::size_t validate_utf8();
+
+        /// @param offset is relative to the start of the buffer, not a global one
         std::pair<Line, Column> get_line_column(Offset offset);
         std::string get_line_text(Line line_no);
     };
 
+    /// What loading a file from disk came to, kept so it can be reported on whichever thread owns
+    /// the DiagnosticsEngine.
+    struct File_Load {
+        std::string path;
+        FileID id = 0;                              // SOURCE_MANAGER_INVALID_FILE_ID if it could not be added
+        std::optional<diag::DiagID> diagnostic;     // what is wrong with the file, if anything
+        Source_Location location;                   // where in the file, invalid if it is about the whole file
+
+        void report(diag::DiagnosticsEngine &diag) const;
+    };
+
+    /// Owns every buffer and lays them out back to back in one 32-bit offset space, so a
+    /// Source_Location is a single offset. Each buffer's slice is one longer than its contents,
+    /// leaving room for the location just past its end (where eof is).
+    ///
+    /// Buffers released once their translation unit is done are kept in memory up to the cache limit,
+    /// past it the least recently used are dropped and read back in when a line or column lookup needs them.
+    ///
+    /// Files can be added from any number of threads at once. Buffers never move once added, so the
+    /// pointers getBuffer hands out stay valid for the lifetime of the manager, and looking buffers
+    /// up takes no lock. The line and column queries share one lock, as they build line tables lazily.
     class Source_Manager {
-        std::unordered_map<FileID, Buffer> buffers;
-        FileID next_file_id_ = 1;
+        Append_Only_Table<Buffer> buffers;          // buffers[id - 1], in slice order
+        mutable std::atomic<FileID> last_file_{0};  // file the last lookup resolved to, checked before searching
+
+        mutable std::mutex add_mutex;               // guards everything below, and appending to `buffers`
+        Offset next_offset_ = 1;                    // 0 is the invalid location
+        mutable std::mutex lines_mutex;             // held while resolving lines and columns, guards eviction
+
+        std::size_t cache_limit = 0;                // bytes of released contents to keep in memory, 0 keeps all of them
+        mutable std::size_t released_bytes = 0;     // contents of released buffers still in memory
+        mutable std::list<FileID> released_files;   // released buffers still in memory, least recently used first
+        mutable std::unordered_map<FileID, std::list<FileID>::iterator> released_at;
+
+        /// what the file system says about a file, a file whose status is unchanged is not reloaded
+        struct File_Status {
+            std::uint64_t device = 0;
+            std::uint64_t inode = 0;
+            std::uint64_t size = 0;
+            std::int64_t mtime = 0;                 // nanoseconds
+
+            bool operator==(const File_Status&) const = default;
+        };
+
+        struct File_Entry {
+            File_Status status;
+            FileID id;
+            std::uint64_t generation = 0;           // of the overlay it was loaded from, 0 if it came from disk
+        };
+
+        /// unsaved contents standing in for the file at a path
+        struct Overlay {
+            std::string contents;
+            std::uint64_t generation;
+        };
+
+        std::unordered_map<std::string, File_Entry> file_entries;   // keyed by canonical path
+        std::unordered_map<std::string, Overlay> overlays;          // keyed by canonical path
+        std::uint64_t next_generation_ = 1;                         // never reused, so a stale entry can't match
+        std::unordered_multimap<std::size_t, FileID> content_ids;   // files loaded from disk, by hash of their contents
+
+        /// Hand `buffer` the next slice of the offset space, `add_mutex` must be held.
+        /// @returns its FileID, or SOURCE_MANAGER_INVALID_FILE_ID if the space is used up
+        FileID add(Buffer buffer);
+
+        /// the buffer `loc` falls in, or nullptr if it is invalid
+        const Buffer* find_buffer(Source_Location loc) const;
+
+        /// Drop the contents of released buffers, least recently used first, until they fit in the cache
+        /// limit again, `lines_mutex` must be held. `keep` is never dropped.
+        void evict_to_limit(FileID keep = 0) const;
+
+        /// Make sure the contents of `id` are in memory, reading them back from disk if they were evicted,
+        /// `lines_mutex` must be held.
+        /// @returns false if the file has changed since it was loaded, and so cannot be read back
+        bool make_resident(FileID id) const;
+
+        /// Count another use of `id`, taking it back from the released buffers if it was released. Both
+        /// mutexes must be held.
+        /// @returns false if its contents were evicted and cannot be read back
+        bool retain_locked(FileID id);
+
+        /// Load `overlay` as the file at `canonical` into `load`, reusing the buffer of its generation if
+        /// there is one. `add_mutex` must be held.
+        void load_overlay(File_Load &load, const std::string &canonical, const Overlay &overlay);
+
+        /// @returns false if `path` cannot be stat'ed
+        static bool stat_file(const std::string &path, File_Status &status);
 
     public:
         Source_Manager() = default;
 
-        /// add a file from a string (in-memory / virtual file). Returns a FileID
+        /// add a file from a string (in-memory / virtual file). Returns a FileID, or
+        /// SOURCE_MANAGER_INVALID_FILE_ID if it does not fit in the offset space that is left
         FileID add_buffer(std::string content, std::string path="");
 
-        /// add a buffer from disk
+        /// Add a buffer from disk, reporting it if its contents are not valid UTF-8. The file is mapped
+        /// rather than read where the platform allows it, so its contents are never copied.
+        ///
+        /// Adding a path again returns the FileID it already has, without touching its contents, for
+        /// as long as the file's inode, size and modification time are unchanged. A file with the same
+        /// contents as one already loaded gets a FileID and buffer of its own, with its own path, that
+        /// share the other file's contents rather than holding a second copy.
         FileID add_file_from_disk(const std::string &path, udo::diag::DiagnosticsEngine &diag);
 
-        /// Get the buffer for a file ID
+        /// add_file_from_disk without the reporting, overlays included, for loading files on a thread that does not own
+        /// the DiagnosticsEngine
+        File_Load load_file(const std::string &path);
+
+        /// Shadow the file at `path` (which need not exist) with `contents`, until the overlay is replaced
+        /// or removed. Loading the path then gives a buffer of the overlay's contents, the same one for as
+        /// long as the overlay is unchanged, while every other file keeps coming from disk.
+        /// @returns the overlay's generation, which grows every time an overlay is set
+        std::uint64_t set_overlay(const std::string &path, std::string contents);
+
+        /// stop shadowing `path`, it is loaded from disk again
+        void remove_overlay(const std::string &path);
+
+        /// generation of the overlay on `path`, or 0 if there is none
+        std::uint64_t overlay_generation(const std::string &path) const;
+
+        /// Keep at most `bytes` of released contents in memory, 0 (the default) keeps all of them.
+        void set_cache_limit(std::size_t bytes);
+
+        /// Mark one load of file `id` as done with. Every load_file (or add_file_from_disk) that hands out
+        /// `id` counts as a use, and once all of them are released nothing views its contents any more, so
+        /// once released files add up to more than the cache limit they can be dropped. Line and column
+        /// lookups still work, they read the file back in (checking it is unchanged) when they need it.
+        /// Loading the file again takes it back out of the released files.
+        ///
+        /// Only files loaded from disk and not edited since are ever dropped.
+        void release(FileID id);
+
+        /// Count another use of `id`, for a load handed out a second time without going through load_file.
+        /// Its contents are read back in if they were evicted.
+        /// @returns false if they were and the file has changed since, so `id` cannot be used again
+        bool retain(FileID id);
+
+        /// FileID `path` was loaded as by add_file_from_disk, or 0 if it was not
+        FileID find_file(const std::string &path) const;
+
+        /// Get the buffer for a file ID, valid for as long as the manager is
         Buffer* getBuffer(FileID id);
         const Buffer* getBuffer(FileID id) const;
 
+        /// the location `offset` bytes into file `id`
+        Source_Location get_location(FileID id, std::size_t offset) const;
+
+        /// the file `loc` falls in, or 0 if it is invalid
+        FileID get_file_id(Source_Location loc) const;
+
+        /// offset of `loc` from the start of its file
+        Offset get_file_offset(Source_Location loc) const;
+
         /// Get line and column for a source location
         std::pair<Line, Column> getLineColumn(Source_Location loc) const;
 
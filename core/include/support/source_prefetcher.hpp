@@ -0,0 +1,69 @@
+//
+// Created by David Yang on 2026-03-19.
+//
+
+#ifndef SOURCE_PREFETCHER_HPP
+#define SOURCE_PREFETCHER_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <support/source_manager.hpp>
+
+namespace udo {
+
+    /// Loads sources into a Source_Manager on a background thread, in the order they are queued,
+    /// so reading one file overlaps with compiling the ones before it.
+    ///
+    /// Read-ahead stops once the sources loaded but not yet taken add up to the memory budget, and
+    /// resumes as they are taken. Diagnostics about a file are held in its File_Load until it is
+    /// taken, so they are reported on the compiling thread, in source order.
+    class Source_Prefetcher {
+    public:
+        /// @param memory_budget bytes of loaded, untaken sources to stay under; a single file larger
+        ///        than the budget is still loaded, but only once nothing else is held
+        Source_Prefetcher(Source_Manager &sources, std::size_t memory_budget);
+        ~Source_Prefetcher();
+
+        Source_Prefetcher(const Source_Prefetcher&) = delete;
+        Source_Prefetcher& operator=(const Source_Prefetcher&) = delete;
+
+        /// queue `path` to be loaded in the background, queueing it again does nothing
+        void enqueue(const std::string &path);
+
+        /// The load of `path`, waiting for it if the background thread is on it. A path the background
+        /// thread has not got to yet (or that was never queued) is loaded on the calling thread instead.
+        /// Every take counts as a use of the file, to be handed back with Source_Manager::release.
+        File_Load take(const std::string &path);
+
+    private:
+        enum class State { queued, loading, ready, taken };
+
+        struct Entry {
+            std::string path;
+            State state = State::queued;
+            File_Load load;
+            std::size_t bytes = 0;      // counted against the budget while ready
+        };
+
+        void run();
+
+        Source_Manager& sources;
+        std::size_t budget;
+        std::size_t held = 0;           // bytes of ready entries not taken yet
+        std::deque<Entry> entries;      // in queue order, a deque so references survive appends
+        std::unordered_map<std::string, std::size_t> index;     // path to its entry
+        std::size_t next = 0;           // first entry the background thread has not looked at
+        bool stopping = false;
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::thread worker;
+    };
+
+} // namespace udo
+
+#endif // SOURCE_PREFETCHER_HPP
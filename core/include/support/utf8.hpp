@@ -0,0 +1,41 @@
+//
+// Created by David Yang on 2026-03-14.
+//
+
+#ifndef UTF8_HPP
+#define UTF8_HPP
+
+#include <cstddef>
+
+namespace udo::utf8 {
+
+    constexpr bool is_ascii(const char c) { return static_cast<unsigned char>(c) < 0x80; }
+
+    /// Decodes the code point starting at `data[0]`, rejecting overlong forms, surrogates and
+    /// anything past U+10FFFF.
+    /// @returns the length in bytes of the sequence, or 0 if it is ill-formed or truncated by `size`
+    std::size_t decode(const char* data, std::size_t size, char32_t& code_point);
+
+    /// Encodes `code_point`, which must be a Unicode scalar value, into `out`.
+    /// @returns the number of bytes written, 1 to 4
+    std::size_t encode(char32_t code_point, char* out);
+
+    /// @returns the end of the run of ASCII bytes in `data[pos, end)`
+    std::size_t ascii_end(const char* data, std::size_t pos, std::size_t end);
+
+    struct Validation {
+        std::size_t first_invalid;  // offset of the first ill-formed sequence, or the size if there is none
+        bool ascii;                 // no byte >= 0x80 before first_invalid
+    };
+
+    /// Validates `data[0, size)` as UTF-8. ASCII runs are skipped 16 bytes at a time and only the
+    /// multi-byte sequences in between are decoded one by one.
+    Validation validate(const char* data, std::size_t size);
+
+    /// number of code points in `data[0, size)`, found by counting the bytes that are not continuation
+    /// bytes, so it costs no decoding (an ill-formed sequence counts as however many lead bytes it has)
+    std::size_t count_code_points(const char* data, std::size_t size);
+
+} // namespace udo::utf8
+
+#endif // UTF8_HPP
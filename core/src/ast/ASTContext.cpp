@@ -64,7 +64,11 @@ void ASTContext::Slab::reset() {
 }
 
 ASTContext::ASTContext(std::size_t initial_slab_size)
-    : allocator(initial_slab_size) {
+    : allocator(initial_slab_size),
+      identifier_allocator(identifier_slab_size),
+      identifiers(&identifier_allocator, [](void* arena, const std::size_t size, const std::size_t align) {
+          return static_cast<BumpPtrAllocator<>*>(arena)->allocate(size, align);
+      }) {
     tu_decl = create<TranslationUnitDecl>();
 }
 
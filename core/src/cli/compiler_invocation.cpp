@@ -1,8 +1,14 @@
 #include <cli/compiler_invocation.hpp>
 #include <parser/parser.hpp>
 
+#include <lexer/token_channel.hpp>
+#include <support/source_prefetcher.hpp>
+
+#include <algorithm>
+#include <cassert>
 #include <filesystem>
 #include <iostream>
+#include <thread>
 #include <cli/argparse.hpp>
 #include <utility>
 
@@ -50,6 +56,9 @@ Compiler_Config parse(int argc, char *argv[]) {
 
     bool verbose        = false;
     int  max_error_count = 20;
+    bool pipeline_frontend = false;
+    int  prefetch_budget_mb = 256;
+    int  source_cache_limit_mb = 0;
 
     // optimization flags
     bool opt_O0 = false;
@@ -100,6 +109,23 @@ Compiler_Config parse(int argc, char *argv[]) {
         .scan<'d', int>()
         .store_into(max_error_count);
 
+    program.add_argument("--fpipeline-frontend")
+        .help("Lex and parse each source concurrently on separate threads")
+        .flag()
+        .store_into(pipeline_frontend);
+
+    program.add_argument("--fprefetch-budget")
+        .help("Megabytes of sources to read ahead in the background while earlier ones compile")
+        .nargs(1, 1)
+        .scan<'d', int>()
+        .store_into(prefetch_budget_mb);
+
+    program.add_argument("--fsource-cache-limit")
+        .help("Megabytes of finished sources to keep in memory for late diagnostics (0 keeps all of them)")
+        .nargs(1, 1)
+        .scan<'d', int>()
+        .store_into(source_cache_limit_mb);
+
     // -o
     program.add_argument("-o", "--output")
         .help("Specify output file (final artifact or single-file output)")
@@ -334,10 +360,19 @@ Compiler_Config parse(int argc, char *argv[]) {
     if (!program.is_used("--fmax-error-count")) {
         max_error_count = 20;
     }
+    if (!program.is_used("--fprefetch-budget")) {
+        prefetch_budget_mb = 256;
+    }
+    if (!program.is_used("--fsource-cache-limit")) {
+        source_cache_limit_mb = 0;
+    }
 
     Flags flags;
     flags.verbose         = verbose;
     flags.max_error_count = max_error_count;
+    flags.pipeline_frontend = pipeline_frontend;
+    flags.prefetch_budget = static_cast<std::size_t>(std::max(prefetch_budget_mb, 0)) << 20;
+    flags.source_cache_limit = static_cast<std::size_t>(std::max(source_cache_limit_mb, 0)) << 20;
     flags.level           = opt_level;
     flags.output_format   = format;
     flags.output_file     = o_output;
@@ -379,8 +414,22 @@ Preprocessor Preprocessor_Invoke::invoke() const {
 Lexer_Invoke::Lexer_Invoke(const Param &param) : param(param) {}
 
 std::unique_ptr<Lexer> Lexer_Invoke::invoke() const {
-    // Minimal construction; you can add extra wiring where you actually use it.
-    return std::make_unique<Lexer>(param.input_Stream);
+    if (param.sources) {
+        // lex straight out of the buffer the Source_Manager already owns
+        const Buffer* buffer = param.sources->getBuffer(param.file);
+        if (!buffer) {
+            param.diag.Report(Source_Location{}, diag::common::err_file_not_found)
+                << std::to_string(param.file);
+            return nullptr;
+        }
+        auto lexer = std::make_unique<Lexer>(*buffer, param.file);
+        lexer->set_diagnostics(&param.diag);
+        return lexer;
+    }
+
+    assert(param.input_Stream && "Lexer_Invoke needs either a stream or a file in a Source_Manager");
+    if (!param.input_Stream) return nullptr;
+    return std::make_unique<Lexer>(*param.input_Stream);
 }
 
 Parser_Invoke::Parser_Invoke(const Param& param) : param(param) {}
@@ -434,10 +483,51 @@ int Compiler_Invocation::run() {
     // - decides per-source vs single-output behaviour
     // - computes object file names for linking
     // - calls Linker_Invoke if needed
-    // The actual calls to preprocessor / lexer / parser / sema / codegen
+    // The actual calls to preprocessor / sema / codegen
     // are left to you.
 
+    Source_Manager sources;
+    sources.set_cache_limit(config.flags.source_cache_limit);
+    // every source is read in the background while the ones before it compile
+    Source_Prefetcher prefetcher(sources, config.flags.prefetch_budget);
+    for (const std::string& path : config.sources) prefetcher.enqueue(path);
+
+    for (const std::string& path : config.sources) {
+        const File_Load load = prefetcher.take(path);
+        load.report(diag_);
+        const FileID file = load.id;
+        if (file == static_cast<FileID>(SOURCE_MANAGER_INVALID_FILE_ID)) continue;
+
+        const std::unique_ptr<Lexer> lexer = Lexer_Invoke({diag_, nullptr, &sources, file}).invoke();
+        if (!lexer) continue;
+        // the identifier table has an arena and lock of its own, so the lexer interns on whichever thread it runs
+        lexer->set_identifier_table(&context_.get_identifier_table());
+
+        if (!config.flags.pipeline_frontend) {
+            // the parser pulls tokens straight out of the lexer, on this thread
+            lexer->set_string_storage({&context_, &ASTContext::store_string});
+            Parser_Invoke({diag_, context_, *lexer, config.flags}).invoke()->parse();
+            sources.release(file);
+            continue;
+        }
+
+        // the lexer runs ahead on its own thread while the parser drains the channel on this one.
+        // escaped literals end up in the AST arena through the parser rather than the lexer, since the
+        // parser is allocating from it concurrently, and lexer diagnostics wait until the engine is free again
+        lexer->set_diagnostics(nullptr);
+        Token_Channel channel;
+        std::thread lexer_thread([&] { channel.produce_from(*lexer); });
+
+        Parser_Invoke({diag_, context_, channel, config.flags}).invoke()->parse();
+
+        channel.cancel();
+        lexer_thread.join();
+        lexer->flush_diagnostics(diag_);
+        // the last stage to look at the source text, later diagnostics read it back in if it is evicted
+        sources.release(file);
+    }
 
+    if (diag_.hasErrorOccurred()) return 1;
 
     return 0;
 }
@@ -475,6 +475,9 @@ Severity DiagnosticsEngine::getDefaultSeverity(DiagID id) const {
         return Severity::Error;
     }
     if (id >= DIAG_START_LEXER && id < DIAG_START_PARSER) {
+        if (id == lex::warn_multi_char_constant) {
+            return Severity::Warning;
+        }
         return Severity::Error;  // Lexer errors are usually errors
     }
     if (id >= DIAG_START_PARSER && id < DIAG_START_SEMA) {
@@ -493,6 +496,14 @@ const char* DiagnosticsEngine::getDiagnosticFormatString(DiagID id) const {
         case common::warn_unused_variable: return "unused variable '%0'";
         case parse::err_expected_semicolon: return "expected ';'";
         case common::err_file_not_found: return "file not found: '%0'";
+        case common::err_file_too_large: return "'%0' does not fit in the 4 GB of source locations left";
+        case lex::err_unterminated_string: return "unterminated string literal";
+        case lex::err_unterminated_char: return "unterminated character literal";
+        case lex::err_unterminated_block_comment: return "unterminated block comment";
+        case lex::err_invalid_escape_sequence: return "invalid escape sequence";
+        case lex::err_empty_character_literal: return "empty character literal";
+        case lex::warn_multi_char_constant: return "multi-character character literal";
+        case lex::err_invalid_utf8: return "source file is not valid UTF-8";
         default: return nullptr;
     }
 }
@@ -0,0 +1,214 @@
+//
+// Created by David Yang on 2026-03-04.
+//
+
+#include <lexer/char_scan.hpp>
+
+#include <bit>
+#include <cstring>
+
+// SSE2 is part of the x86-64 baseline, AVX2 is compiled in through target attributes
+// and only picked at runtime when the CPU reports it.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+    #define UDO_SCAN_SSE2 1
+    #include <immintrin.h>
+#endif
+
+#if defined(UDO_SCAN_SSE2) && (defined(__GNUC__) || defined(__clang__))
+    #define UDO_SCAN_AVX2 1
+    #define UDO_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace udo::lexer {
+
+    namespace {
+
+        enum class Run {
+            whitespace,
+            identifier,
+            digit,
+            newline,
+            string_stop,
+            char_stop,
+        };
+
+        // -----------------------------------------------
+        //                     Scalar
+        // -----------------------------------------------
+
+        template <std::uint8_t Class>
+        std::size_t scalar_run(const char* data, std::size_t pos, const std::size_t end) {
+            while (pos < end && has_class(data[pos], Class)) ++pos;
+            return pos;
+        }
+
+        std::size_t scalar_find_newline(const char* data, const std::size_t pos, const std::size_t end) {
+            if (pos >= end) return end;
+            const void* found = std::memchr(data + pos, '\n', end - pos);
+            return found ? static_cast<std::size_t>(static_cast<const char*>(found) - data) : end;
+        }
+
+        template <char Quote>
+        std::size_t scalar_find_quote_or_escape(const char* data, std::size_t pos, const std::size_t end) {
+            while (pos < end && data[pos] != Quote && data[pos] != '\\') ++pos;
+            return pos;
+        }
+
+        constexpr Char_Scanners scalar_scanners{
+            Scan_ISA::scalar, "scalar",
+            scalar_run<cc_space>, scalar_run<cc_ident>, scalar_run<cc_digit>, scalar_find_newline,
+            scalar_find_quote_or_escape<'"'>, scalar_find_quote_or_escape<'\''>,
+        };
+
+#ifdef UDO_SCAN_SSE2
+        // -----------------------------------------------
+        //                      SSE2
+        // -----------------------------------------------
+
+        // bytes within [lo, hi], compared unsigned
+        inline __m128i sse2_in_range(const __m128i v, const char lo, const char hi) {
+            const __m128i shifted = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+            const __m128i limit = _mm_set1_epi8(static_cast<char>(hi - lo));
+            return _mm_cmpeq_epi8(_mm_max_epu8(shifted, limit), limit);
+        }
+
+        template <Run R>
+        inline __m128i sse2_matches(const __m128i v) {
+            if constexpr (R == Run::whitespace) {
+                // \t through \r, minus \n, plus ' '
+                const __m128i controls = _mm_andnot_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), sse2_in_range(v, '\t', '\r'));
+                return _mm_or_si128(controls, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+            } else if constexpr (R == Run::identifier) {
+                // or-ing in 0x20 folds A-Z onto a-z and maps nothing else into that range
+                const __m128i alpha = sse2_in_range(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+                const __m128i digit = sse2_in_range(v, '0', '9');
+                return _mm_or_si128(_mm_or_si128(alpha, digit), _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+            } else if constexpr (R == Run::digit) {
+                return sse2_in_range(v, '0', '9');
+            } else if constexpr (R == Run::string_stop || R == Run::char_stop) {
+                const __m128i quote = _mm_cmpeq_epi8(v, _mm_set1_epi8(R == Run::string_stop ? '"' : '\''));
+                return _mm_or_si128(quote, _mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+            } else {
+                return _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+            }
+        }
+
+        /// a run scanner stops at the first byte that does not match, the find_ scanners at the first one that does
+        template <Run R>
+        std::size_t sse2_scan(const char* data, std::size_t pos, const std::size_t end) {
+            constexpr bool stop_on_match = R == Run::newline || R == Run::string_stop || R == Run::char_stop;
+            while (pos + 16 <= end) {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+                auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(sse2_matches<R>(v)));
+                if constexpr (!stop_on_match) mask = ~mask & 0xFFFFu;
+                if (mask != 0) return pos + std::countr_zero(mask);
+                pos += 16;
+            }
+            if constexpr (R == Run::whitespace) return scalar_run<cc_space>(data, pos, end);
+            else if constexpr (R == Run::identifier) return scalar_run<cc_ident>(data, pos, end);
+            else if constexpr (R == Run::digit) return scalar_run<cc_digit>(data, pos, end);
+            else if constexpr (R == Run::string_stop) return scalar_find_quote_or_escape<'"'>(data, pos, end);
+            else if constexpr (R == Run::char_stop) return scalar_find_quote_or_escape<'\''>(data, pos, end);
+            else return scalar_find_newline(data, pos, end);
+        }
+
+        constexpr Char_Scanners sse2_scanners{
+            Scan_ISA::sse2, "sse2",
+            sse2_scan<Run::whitespace>, sse2_scan<Run::identifier>, sse2_scan<Run::digit>, sse2_scan<Run::newline>,
+            sse2_scan<Run::string_stop>, sse2_scan<Run::char_stop>,
+        };
+#endif
+
+#ifdef UDO_SCAN_AVX2
+        // -----------------------------------------------
+        //                      AVX2
+        // -----------------------------------------------
+
+        UDO_TARGET_AVX2 inline __m256i avx2_in_range(const __m256i v, const char lo, const char hi) {
+            const __m256i shifted = _mm256_sub_epi8(v, _mm256_set1_epi8(lo));
+            const __m256i limit = _mm256_set1_epi8(static_cast<char>(hi - lo));
+            return _mm256_cmpeq_epi8(_mm256_max_epu8(shifted, limit), limit);
+        }
+
+        template <Run R>
+        UDO_TARGET_AVX2 inline __m256i avx2_matches(const __m256i v) {
+            if constexpr (R == Run::whitespace) {
+                const __m256i controls = _mm256_andnot_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), avx2_in_range(v, '\t', '\r'));
+                return _mm256_or_si256(controls, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+            } else if constexpr (R == Run::identifier) {
+                const __m256i alpha = avx2_in_range(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z');
+                const __m256i digit = avx2_in_range(v, '0', '9');
+                return _mm256_or_si256(_mm256_or_si256(alpha, digit), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+            } else if constexpr (R == Run::digit) {
+                return avx2_in_range(v, '0', '9');
+            } else if constexpr (R == Run::string_stop || R == Run::char_stop) {
+                const __m256i quote = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(R == Run::string_stop ? '"' : '\''));
+                return _mm256_or_si256(quote, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')));
+            } else {
+                return _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'));
+            }
+        }
+
+        template <Run R>
+        UDO_TARGET_AVX2 std::size_t avx2_scan(const char* data, std::size_t pos, const std::size_t end) {
+            constexpr bool stop_on_match = R == Run::newline || R == Run::string_stop || R == Run::char_stop;
+            // most runs are shorter than 32 bytes, they never touch a ymm register (or build the constants)
+            if (pos + 32 <= end) {
+                do {
+                    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+                    auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(avx2_matches<R>(v)));
+                    if constexpr (!stop_on_match) mask = ~mask;
+                    if (mask != 0) return pos + std::countr_zero(mask);
+                    pos += 32;
+                } while (pos + 32 <= end);
+                // the tail runs legacy SSE code, which stalls on dirty upper halves of the ymm registers
+                _mm256_zeroupper();
+            }
+            // finish the (up to 31 byte) tail 16 bytes at a time
+            return sse2_scan<R>(data, pos, end);
+        }
+
+        constexpr Char_Scanners avx2_scanners{
+            Scan_ISA::avx2, "avx2",
+            avx2_scan<Run::whitespace>, avx2_scan<Run::identifier>, avx2_scan<Run::digit>, avx2_scan<Run::newline>,
+            avx2_scan<Run::string_stop>, avx2_scan<Run::char_stop>,
+        };
+
+        bool cpu_has_avx2() {
+            return __builtin_cpu_supports("avx2");
+        }
+#endif
+
+    } // namespace
+
+    const Char_Scanners* get_scanners(const Scan_ISA isa) {
+        switch (isa) {
+            case Scan_ISA::scalar:
+                return &scalar_scanners;
+            case Scan_ISA::sse2:
+#ifdef UDO_SCAN_SSE2
+                return &sse2_scanners;
+#else
+                return nullptr;
+#endif
+            case Scan_ISA::avx2:
+#ifdef UDO_SCAN_AVX2
+                return cpu_has_avx2() ? &avx2_scanners : nullptr;
+#else
+                return nullptr;
+#endif
+        }
+        return nullptr;
+    }
+
+    const Char_Scanners& active_scanners() {
+        static const Char_Scanners& active = *[] {
+            for (const Scan_ISA isa : {Scan_ISA::avx2, Scan_ISA::sse2}) {
+                if (const Char_Scanners* scanners = get_scanners(isa)) return scanners;
+            }
+            return &scalar_scanners;
+        }();
+        return active;
+    }
+
+} // namespace udo::lexer
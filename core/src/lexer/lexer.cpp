@@ -1,68 +1,494 @@
 #include <lexer/lexer.hpp>
+#include <error/error.hpp>
+#include <support/utf8.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <iterator>
+#include <thread>
 
 namespace udo::lexer {
 
+    namespace {
+
+        bool is_digit_separator(const char c) { return c == '_' || c == '\''; }
+
+        /// Unicode spaces and the byte order mark, the only non-ASCII code points that cannot be in an identifier
+        constexpr bool is_unicode_space(const char32_t c) {
+            return c == 0x85 || c == 0xA0 || c == 0x1680 || (c >= 0x2000 && c <= 0x200A) || c == 0x2028
+                || c == 0x2029 || c == 0x202F || c == 0x205F || c == 0x3000 || c == 0xFEFF;
+        }
+
+        /// @returns the length of the non-ASCII identifier character at `line[pos]`, or 0 if there is none there
+        std::size_t unicode_identifier_length(const std::string_view line, const std::size_t pos) {
+            char32_t code_point;
+            const std::size_t length = utf8::decode(line.data() + pos, line.size() - pos, code_point);
+            return length > 1 && !is_unicode_space(code_point) ? length : 0;
+        }
+
+        /// decode the digits of a numeric literal, everything between its base prefix and its suffix
+        Numeric_Literal decode_numeric_literal(const std::string_view digits, const int base, const bool is_float, const std::string_view suffix) {
+            Numeric_Literal literal;
+            literal.base = static_cast<std::uint8_t>(base);
+            literal.is_float = is_float;
+
+            for (std::size_t i = 0; i < suffix.size(); ++i) {
+                switch (to_lower(suffix[i])) {
+                    case 'u': literal.suffix |= ls_unsigned; break;
+                    case 'z': literal.suffix |= ls_size; break;
+                    case 'f': literal.suffix |= ls_float; break;
+                    case 'l':
+                        if (i + 1 < suffix.size() && to_lower(suffix[i + 1]) == 'l') {
+                            literal.suffix |= ls_long_long;
+                            ++i;
+                        } else {
+                            literal.suffix |= ls_long;
+                        }
+                        break;
+                    default: break;
+                }
+            }
+
+            if (!is_float) {
+                for (const char c : digits) {
+                    if (is_digit_separator(c)) continue;
+                    const auto digit = static_cast<std::uint32_t>(is_digit(c) ? c - '0' : to_lower(c) - 'a' + 10);
+                    if (!literal.integer.mul_add(static_cast<std::uint32_t>(base), digit)) literal.out_of_range = true;
+                }
+                return literal;
+            }
+
+            // from_chars takes neither separators nor the 0x prefix of hex floats
+            std::string text;
+            text.reserve(digits.size());
+            for (const char c : digits) {
+                if (!is_digit_separator(c)) text.push_back(c);
+            }
+            const auto format = base == 16 ? std::chars_format::hex : std::chars_format::general;
+            const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), literal.floating, format);
+            if (error == std::errc::result_out_of_range) literal.out_of_range = true;
+            return literal;
+        }
+
+        /// value of hex digit `c`, or -1 if it is not one
+        int hex_value(const char c) {
+            if (is_digit(c)) return c - '0';
+            const char lower = to_lower(c);
+            return lower >= 'a' && lower <= 'f' ? lower - 'a' + 10 : -1;
+        }
+
+        /// decode the single escape sequence at the front of `text`, appending it to `out`
+        /// @returns the length of the escape sequence, or 0 if it is not a valid one
+        std::size_t decode_escape(const std::string_view text, std::string &out) {
+            if (text.size() < 2) return 0;
+            switch (text[1]) {
+                case 'n': out.push_back('\n'); return 2;
+                case 't': out.push_back('\t'); return 2;
+                case 'r': out.push_back('\r'); return 2;
+                case 'v': out.push_back('\v'); return 2;
+                case 'f': out.push_back('\f'); return 2;
+                case 'b': out.push_back('\b'); return 2;
+                case 'a': out.push_back('\a'); return 2;
+                case '0': out.push_back('\0'); return 2;
+                case '\\': case '\'': case '"': out.push_back(text[1]); return 2;
+                case 'x': {
+                    if (text.size() < 4) return 0;
+                    const int high = hex_value(text[2]), low = hex_value(text[3]);
+                    if (high < 0 || low < 0) return 0;
+                    out.push_back(static_cast<char>(high << 4 | low));
+                    return 4;
+                }
+                case 'u': {
+                    // \u{1F600}, one to six hex digits
+                    if (text.size() < 4 || text[2] != '{') return 0;
+                    char32_t code_point = 0;
+                    std::size_t i = 3;
+                    for (; i < text.size() && i < 9 && text[i] != '}'; ++i) {
+                        const int digit = hex_value(text[i]);
+                        if (digit < 0) return 0;
+                        code_point = code_point << 4 | static_cast<char32_t>(digit);
+                    }
+                    if (i == 3 || i >= text.size() || text[i] != '}') return 0;
+                    if (code_point > 0x10FFFF || (code_point >= 0xD800 && code_point <= 0xDFFF)) return 0;
+                    char encoded[4];
+                    out.append(encoded, utf8::encode(code_point, encoded));
+                    return i + 1;
+                }
+                default: return 0;
+            }
+        }
+
+    } // namespace
+
+    std::size_t decode_escapes(const std::string_view contents, std::string &out) {
+        std::size_t first_invalid = std::string_view::npos;
+        std::size_t pos = 0;
+        while (pos < contents.size()) {
+            const std::size_t backslash = contents.find('\\', pos);
+            out.append(contents.substr(pos, backslash - pos));
+            if (backslash == std::string_view::npos) break;
+
+            if (const std::size_t length = decode_escape(contents.substr(backslash), out); length > 0) {
+                pos = backslash + length;
+            } else {
+                if (first_invalid == std::string_view::npos) first_invalid = backslash;
+                out.push_back('\\');
+                pos = backslash + 1;
+            }
+        }
+        return first_invalid;
+    }
+
+
+    static_assert((Lexer::max_lookahead & (Lexer::max_lookahead - 1)) == 0, "lookahead ring size must be a power of two");
 
     Lexer::Lexer(std::istream &input_stream)
-        : input(input_stream), current_pos(0), line_number(1), symbols(udo::lexer::symbols())
+        : buffer(&owned_buffer), scanners(&active_scanners()), current_pos(0), trivia_start(0)
     {
+        owned_buffer.data.assign(std::istreambuf_iterator<char>(input_stream), std::istreambuf_iterator<char>());
+        source = owned_buffer.data;
+        reset();
     }
 
-    std::tuple<std::vector<Token>, std::vector<Token>, std::map<int, std::string>> Lexer::tokenize() {
-        std::vector<Token> tokens;
-        std::string line;
+    Lexer::Lexer(const Buffer &buffer, const FileID file)
+        : buffer(&buffer), source(buffer.text()), file(file), scanners(&active_scanners()), current_pos(0), trivia_start(0)
+    {
+        reset();
+    }
 
-        while (std::getline(input, line)) {
-            current_line = line;
-            current_pos = 0;
-            spaces.clear();
+    void Lexer::reset() {
+        current_line = {};
+        current_pos = 0;
+        trivia_start = 0;
+        next_line_start = 0;
+        range_end = source.size();
+        line_end = 0;
+        in_line = false;
+        lookahead_head = 0;
+        lookahead_count = 0;
+        last_token = {};
+    }
 
-            while (current_pos < current_line.size()) {
-                char current_char = current_line[current_pos];
+    void Lexer::flush_diagnostics(diag::DiagnosticsEngine &engine) {
+        for (const auto &[location, id] : pending_diagnostics) engine.Report(location, id);
+        pending_diagnostics.clear();
+    }
 
-                if (std::isspace(current_char)) {
-                    spaces += current_char;
-                    ++current_pos;
-                    continue;
-                }
+    void Lexer::report(const std::size_t offset, const diag::DiagID id) {
+        const Source_Location location = location_of(offset);
+        if (diagnostics) diagnostics->Report(location, id);
+        else pending_diagnostics.push_back({location, id});
+    }
 
-                if (std::isdigit(current_char)) {
-                    tokens.push_back(tokenize_number());
-                    continue;
-                }
+    TokenStream Lexer::tokenize() {
+        return lex_all(nullptr);
+    }
 
-                if (std::isalpha(current_char) || current_char == '_') {
-                    tokens.push_back(tokenize_identifier());
-                    continue;
-                }
+    TokenStream Lexer::tokenize(Trivia_Table &trivia) {
+        trivia.clear();
+        return lex_all(&trivia);
+    }
+
+    TokenStream Lexer::lex_all(Trivia_Table *trivia) {
+        TokenStream tokens(buffer, location_of(0));
+        const std::vector<std::size_t> bounds = chunk_boundaries();
+
+        if (bounds.size() <= 2) {
+            // rough guess of one token every four bytes, saves most of the regrowth on big inputs
+            tokens.reserve(source.size() / 4 + 1);
+            lex_range(0, source.size(), tokens, trivia);
+            return tokens;
+        }
+
+        const std::size_t chunks = bounds.size() - 1;
+        std::vector<TokenStream> chunk_tokens(chunks, TokenStream(buffer, location_of(0)));
+        std::vector<Trivia_Table> chunk_trivia(trivia ? chunks : 0);
+        std::vector<std::vector<Lexer_Diagnostic>> chunk_diagnostics(chunks);
+        std::vector<std::size_t> chunk_ends(chunks);
+
+        // Every chunk gets a lexer of its own over the same buffer, the first one is lexed right here.
+        // Workers hold their diagnostics back and leave escaped literals undecoded, neither the engine
+        // nor the string storage can be used from several threads.
+        const auto lex_chunk = [&](const std::size_t i, const std::size_t begin) {
+            Lexer worker(*buffer, file);
+            worker.identifiers = identifiers;
+            worker.scanners = scanners;
+            chunk_tokens[i].reserve((bounds[i + 1] - begin) / 4 + 1);
+            chunk_ends[i] = worker.lex_range(begin, bounds[i + 1], chunk_tokens[i], trivia ? &chunk_trivia[i] : nullptr);
+            chunk_diagnostics[i] = std::move(worker.pending_diagnostics);
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(chunks - 1);
+        for (std::size_t i = 1; i < chunks; ++i) workers.emplace_back(lex_chunk, i, bounds[i]);
+        lex_chunk(0, bounds[0]);
+        for (std::thread &worker : workers) worker.join();
+
+        // Chunks start right after a '\n' and only block comments cross lines, so unless a chunk starts
+        // inside a comment it is lexed from the same state a sequential lex would be in at that point.
+        // A comment left open at the end of a chunk was followed to its end by that chunk's lexer,
+        // whatever the next chunks made of the text inside it is thrown away and lexed again from there.
+        for (std::size_t i = 1; i < chunks; ++i) {
+            if (chunk_ends[i - 1] <= bounds[i]) continue;
+            chunk_tokens[i].clear();
+            if (trivia) chunk_trivia[i].clear();
+            chunk_diagnostics[i].clear();
+            if (chunk_ends[i - 1] >= bounds[i + 1]) {
+                chunk_ends[i] = chunk_ends[i - 1];
+                continue;
+            }
+            lex_chunk(i, chunk_ends[i - 1]);
+        }
+
+        std::size_t total = 0;
+        for (const TokenStream &chunk : chunk_tokens) total += chunk.size();
+        tokens.reserve(total);
+        for (std::size_t i = 0; i < chunks; ++i) {
+            if (trivia) trivia->append(chunk_trivia[i], static_cast<std::uint32_t>(tokens.size()));
+            tokens.append(chunk_tokens[i]);
+            for (const auto &[location, id] : chunk_diagnostics[i]) report(location.offset - buffer->start, id);
+        }
+
+        if (strings) {
+            tokens.decode_pending_strings([&](const std::size_t idx) {
+                escape_scratch.clear();
+                decode_escapes(string_contents(tokens.lexeme(idx)), escape_scratch);
+                return std::string_view{strings.store(strings.arena, escape_scratch), escape_scratch.size()};
+            });
+        }
+        return tokens;
+    }
+
+    std::vector<std::size_t> Lexer::chunk_boundaries() const {
+        std::vector<std::size_t> bounds{0};
+        if (source.size() >= parallel.threshold && parallel.min_chunk > 0) {
+            const unsigned hardware = parallel.max_threads ? parallel.max_threads : std::thread::hardware_concurrency();
+            const std::size_t chunks = std::min<std::size_t>(std::max(1u, hardware), source.size() / parallel.min_chunk);
+
+            for (std::size_t i = 1; i < chunks; ++i) {
+                // move every cut forward to just past the next newline
+                const std::size_t target = std::max(source.size() / chunks * i, bounds.back());
+                const std::size_t cut = scanners->find_newline(source.data(), target, source.size()) + 1;
+                if (cut >= source.size()) break;
+                if (cut > bounds.back()) bounds.push_back(cut);
+            }
+        }
+        bounds.push_back(source.size());
+        return bounds;
+    }
+
+    std::size_t Lexer::lex_range(const std::size_t begin, const std::size_t end, TokenStream &tokens, Trivia_Table *trivia) {
+        reset();
+        next_line_start = begin;
+        range_end = end;
+
+        for (;;) {
+            const Token token = lex_token();
+            // range_end only moves past `end` when a block comment does
+            if (token.type == TokenType::eof && range_end != source.size()) break;
+
+            append_token(tokens, trivia, token);
 
-                if (is_symbol_start(current_char)) {
-                    tokens.push_back(tokenize_symbol());
-                    continue;
+            if (token.type == TokenType::eof) break;
+        }
+
+        const std::size_t lexed_end = range_end;
+        reset();
+        return lexed_end;
+    }
+
+    void Lexer::append_token(TokenStream &tokens, Trivia_Table *trivia, const Token &token) const {
+        const auto start = static_cast<std::uint32_t>(token.location.offset - buffer->start);
+        if (trivia && start > trivia_start) {
+            const auto trivia_offset = static_cast<std::uint32_t>(trivia_start);
+            trivia->push(static_cast<std::uint32_t>(tokens.size()), trivia_offset, start - trivia_offset);
+        }
+        tokens.push(token.type, start, static_cast<std::uint32_t>(token.lexeme.size()));
+        if (is_numeric_literal(token.type)) tokens.push_literal(decoded_literal);
+        if (token.identifier) tokens.push_identifier(token.identifier);
+        if (is_quoted_literal(token.type) && string_escaped) tokens.push_string(escaped_string);
+    }
+
+    std::optional<Relex_Result> Lexer::relex(Buffer &buffer, const FileID file, TokenStream &tokens, const Source_Edit &edit,
+                              Trivia_Table *trivia, IdentifierTable *identifiers, const String_Storage &strings,
+                              diag::DiagnosticsEngine *diagnostics) {
+        assert(edit.offset + edit.removed <= buffer.text().size() && "edit runs past the end of the buffer");
+        // the eof location is one past the end, beyond the slice it would fall in the next file's
+        const std::size_t new_size = buffer.text().size() - edit.removed + edit.inserted.size();
+        if (buffer.slice_size != 0 && new_size + 1 > buffer.slice_size) return std::nullopt;
+
+        const std::int64_t shift = static_cast<std::int64_t>(edit.inserted.size()) - static_cast<std::int64_t>(edit.removed);
+        // a mapped file is copied out once, on its first edit
+        buffer.make_owned().replace(edit.offset, edit.removed, edit.inserted);
+        buffer.computed = false;
+        buffer.encoding_checked = false;
+
+        // everything before the line the edit starts on is untouched, in both the old and the new text
+        const auto start_of_line = [&](const std::size_t offset) -> std::size_t {
+            const std::size_t newline_before = offset == 0 ? std::string::npos : buffer.data.rfind('\n', offset - 1);
+            return newline_before == std::string::npos ? 0 : newline_before + 1;
+        };
+        std::size_t line_start = start_of_line(edit.offset);
+        const std::size_t inserted_end = edit.offset + edit.inserted.size();
+
+        std::size_t first = tokens.lower_bound(static_cast<std::uint32_t>(line_start));
+        if (first > 0 && tokens.offset(first - 1) + tokens.length(first - 1) > line_start) {
+            // the line starts inside a block comment, which has to be lexed again from its own line
+            --first;
+            line_start = start_of_line(tokens.offset(first));
+        }
+
+        Lexer worker(buffer, file);
+        worker.identifiers = identifiers;
+        worker.strings = strings;
+        worker.diagnostics = diagnostics;
+        worker.next_line_start = line_start;
+
+        TokenStream window(&buffer, Source_Location(buffer.start));
+        Trivia_Table window_trivia;
+        std::size_t last = tokens.size();
+
+        for (;;) {
+            const Token token = worker.lex_token();
+            worker.append_token(window, trivia ? &window_trivia : nullptr, token);
+
+            if (token.type == TokenType::eof) break;
+
+            // a newline token past the inserted text that the old stream has a newline token for as well is
+            // a line start both agree on (neither is inside a block comment there), the old stream picks up
+            // again with the first token after its copy of that newline
+            const auto start = static_cast<std::uint32_t>(token.location.offset - buffer.start);
+            if (token.type == TokenType::newline && start >= inserted_end && token.lexeme.size() == 1) {
+                const auto old_newline = static_cast<std::uint32_t>(start - shift);
+                const std::size_t old = tokens.lower_bound(old_newline);
+                if (old < tokens.size() && tokens.offset(old) == old_newline && tokens.kind(old) == TokenType::newline) {
+                    last = old + 1;
+                    break;
                 }
+            }
+        }
 
-                tokens.push_back({TokenType::unknown, std::string(1, current_char), line_number, static_cast<int>(current_pos + 1)});
-                unfiltered_tokens.push_back({TokenType::unknown, std::string(1, current_char) + spaces, line_number, static_cast<int>(current_pos + 1)});
-                ++current_pos;
+        tokens.replace(first, last - first, window, shift);
+        if (trivia) {
+            trivia->replace(static_cast<std::uint32_t>(first), static_cast<std::uint32_t>(last - first),
+                            static_cast<std::uint32_t>(window.size()), window_trivia, shift);
+        }
+        return Relex_Result{first, last - first, window.size(), std::move(worker.pending_diagnostics)};
+    }
+
+    Token Lexer::next_token() {
+        if (lookahead_count == 0) {
+            last_token = lex_significant_token();
+            if (is_numeric_literal(last_token.type)) last_literal = decoded_literal;
+            if (is_quoted_literal(last_token.type)) last_string = escaped_string;
+            return last_token;
+        }
+        last_token = lookahead[lookahead_head];
+        if (is_numeric_literal(last_token.type)) last_literal = lookahead_literals[lookahead_head];
+        if (is_quoted_literal(last_token.type)) last_string = lookahead_strings[lookahead_head];
+        lookahead_head = (lookahead_head + 1) & (max_lookahead - 1);
+        --lookahead_count;
+        return last_token;
+    }
+
+    Token Lexer::peek(const std::size_t n) {
+        assert(n < max_lookahead && "peek past the lexer's lookahead window");
+        while (lookahead_count <= n) {
+            const std::size_t slot = (lookahead_head + lookahead_count) & (max_lookahead - 1);
+            lookahead[slot] = lex_significant_token();
+            if (is_numeric_literal(lookahead[slot].type)) lookahead_literals[slot] = decoded_literal;
+            if (is_quoted_literal(lookahead[slot].type)) lookahead_strings[slot] = escaped_string;
+            ++lookahead_count;
+        }
+        return lookahead[(lookahead_head + n) & (max_lookahead - 1)];
+    }
+
+    const Numeric_Literal* Lexer::literal(const Token &token) const {
+        if (!is_numeric_literal(token.type)) return nullptr;
+        if (last_token.type == token.type && last_token.location.offset == token.location.offset) return &last_literal;
+        for (std::size_t i = 0; i < lookahead_count; ++i) {
+            const std::size_t slot = (lookahead_head + i) & (max_lookahead - 1);
+            if (lookahead[slot].location.offset == token.location.offset) return &lookahead_literals[slot];
+        }
+        return nullptr;
+    }
+
+    const std::string_view* Lexer::decoded_string(const Token &token) const {
+        if (!is_quoted_literal(token.type)) return nullptr;
+        const std::string_view* decoded = nullptr;
+        if (last_token.type == token.type && last_token.location.offset == token.location.offset) decoded = &last_string;
+        for (std::size_t i = 0; i < lookahead_count && !decoded; ++i) {
+            const std::size_t slot = (lookahead_head + i) & (max_lookahead - 1);
+            if (lookahead[slot].location.offset == token.location.offset) decoded = &lookahead_strings[slot];
+        }
+        return decoded && decoded->data() ? decoded : nullptr;
+    }
+
+    Token Lexer::lex_significant_token() {
+        Token token = lex_token();
+        while (token.type == TokenType::comment) token = lex_token();
+        return token;
+    }
+
+    Token Lexer::lex_token() {
+        if (!in_line) {
+            if (next_line_start >= range_end) {
+                trivia_start = range_end;
+                return {TokenType::eof, source.substr(range_end, 0), location_of(range_end)};
             }
 
-            tokens.push_back({TokenType::newline, "\n", line_number, 0});
-            unfiltered_tokens.push_back({TokenType::newline, "\n", line_number, 0});
+            // lines are lexed one at a time, so no token can ever run past its own line
+            const std::size_t line_start = next_line_start;
+            line_end = scanners->find_newline(source.data(), line_start, range_end);
+            next_line_start = line_end + 1;
+            current_line = source.substr(line_start, line_end - line_start);
+            current_pos = 0;
+            in_line = true;
+        }
 
-            unfiltered_lines[line_number++] = line;
+        trivia_start = offset_of(current_line.data() + current_pos);
+        if (current_pos < current_line.size() && is_space(current_line[current_pos])) {
+            current_pos = scanners->skip_whitespace(current_line.data(), current_pos + 1, current_line.size());
+        }
 
+        if (current_pos >= current_line.size()) {
+            // an unterminated last line still gets its newline token, just with an empty lexeme
+            in_line = false;
+            const std::size_t newline_length = line_end < source.size() ? 1 : 0;
+            return {TokenType::newline, source.substr(line_end, newline_length), location_of(line_end)};
+        }
 
+        const char current_char = current_line[current_pos];
+        Lexeme lexed;
+        if (is_digit(current_char)) {
+            lexed = tokenize_number();
+        } else if (is_ident_start(current_char)
+                   || (!utf8::is_ascii(current_char) && unicode_identifier_length(current_line, current_pos) > 0)) {
+            lexed = tokenize_identifier();
+        } else if (current_char == '"' || current_char == '\'') {
+            lexed = tokenize_quoted(current_char);
+        } else if (current_char == '/' && current_pos + 1 < current_line.size()
+                   && (current_line[current_pos + 1] == '/' || current_line[current_pos + 1] == '*')) {
+            lexed = tokenize_comment();
+        } else if (is_symbol_start(current_char)) {
+            lexed = tokenize_symbol();
+        } else {
+            // a whole code point when there is a well-formed one, so unknown lexemes are never split mid-sequence
+            char32_t code_point;
+            const std::size_t length = std::max<std::size_t>(
+                utf8::decode(current_line.data() + current_pos, current_line.size() - current_pos, code_point), 1);
+            lexed = {TokenType::unknown, current_line.substr(current_pos, length)};
+            current_pos += length;
         }
 
-        tokens.push_back({TokenType::eof, "", line_number, 0});
-        unfiltered_tokens.push_back({TokenType::eof, "", line_number, 0});
-        return {tokens, unfiltered_tokens, unfiltered_lines};
+        Token token{lexed.type, lexed.text, location_of(offset_of(lexed.text.data()))};
+        if (identifiers && token.type == TokenType::identifier) token.identifier = identifiers->get(token.lexeme);
+        return token;
     }
 
-    Token Lexer::tokenize_number() {
-        int column = static_cast<int>(current_pos) + 1;
-        std::string lexeme;
-        const std::string &s = current_line;
+    Lexer::Lexeme Lexer::tokenize_number() {
+        const std::string_view s = current_line;
         std::size_t start = current_pos;
         bool is_float = false;
         bool has_digits = false;
@@ -73,44 +499,40 @@ namespace udo::lexer {
             char c1 = s[current_pos + 1];
             if (c1 == 'x' || c1 == 'X') {
                 base = 16;
-                lexeme += s[current_pos++];
-                lexeme += s[current_pos++];
+                current_pos += 2;
             } else if (c1 == 'b' || c1 == 'B') {
                 base = 2;
-                lexeme += s[current_pos++];
-                lexeme += s[current_pos++];
+                current_pos += 2;
             } else if (c1 == 'o' || c1 == 'O') {
                 base = 8;
-                lexeme += s[current_pos++];
-                lexeme += s[current_pos++];
-            } else if (std::isdigit(c1)) {
+                current_pos += 2;
+            } else if (is_digit(c1)) {
                 // C-style octal: 0755
                 base = 8;
-                lexeme += s[current_pos++];
+                ++current_pos;
             }
         }
 
+        const std::size_t digits_begin = current_pos;
+
         auto validDigit = [base](char c) -> bool {
-            if (base == 16) return std::isdigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
-            if (base == 10) return std::isdigit(c) != 0;
+            if (base == 16) return is_digit(c) || (to_lower(c) >= 'a' && to_lower(c) <= 'f');
+            if (base == 10) return is_digit(c);
             if (base == 8) return c >= '0' && c <= '7';
             if (base == 2) return c == '0' || c == '1';
             return false;
         };
 
-        auto isSeparator = [](char c) -> bool {
-            return c == '_' || c == '\'';
-        };
-
         // Parse integer part with digit separators
         while (current_pos < s.size()) {
             if (validDigit(s[current_pos])) {
-                lexeme += s[current_pos++];
+                // decimal digit runs are skipped in bulk, other bases a digit at a time
+                current_pos = base == 10 ? scanners->digit_end(s.data(), current_pos + 1, s.size()) : current_pos + 1;
                 has_digits = true;
-            } else if (isSeparator(s[current_pos])) {
+            } else if (is_digit_separator(s[current_pos])) {
                 // Digit separator: must have digit before and after
                 if (has_digits && current_pos + 1 < s.size() && validDigit(s[current_pos + 1])) {
-                    lexeme += s[current_pos++];
+                    ++current_pos;
                 } else {
                     break;
                 }
@@ -120,7 +542,7 @@ namespace udo::lexer {
         }
 
         if (!has_digits) {
-            return {TokenType::unknown, s.substr(start, current_pos - start + 1), line_number, column};
+            return {TokenType::unknown, s.substr(start, current_pos - start + 1)};
         }
 
         // Floating-point handling (only for decimal and hex)
@@ -130,12 +552,12 @@ namespace udo::lexer {
                 if (current_pos + 1 < s.size() && validDigit(s[current_pos + 1])) {
                     // Definitely a float: digit after dot
                     is_float = true;
-                    lexeme += s[current_pos++];
+                    ++current_pos;
 
                     while (current_pos < s.size()) {
                         if (validDigit(s[current_pos]) ||
-                            (isSeparator(s[current_pos]) && current_pos + 1 < s.size() && validDigit(s[current_pos + 1]))) {
-                            lexeme += s[current_pos++];
+                            (is_digit_separator(s[current_pos]) && current_pos + 1 < s.size() && validDigit(s[current_pos + 1]))) {
+                            ++current_pos;
                         } else {
                             break;
                         }
@@ -143,7 +565,7 @@ namespace udo::lexer {
                 } else if (current_pos + 1 >= s.size() || s[current_pos + 1] != '.') {
                     // Trailing dot: 123. is valid, but 123.. is range operator
                     is_float = true;
-                    lexeme += s[current_pos++];
+                    ++current_pos;
                 }
                 // Otherwise: next char is '.', so this is ".." range operator - don't consume
             }
@@ -155,120 +577,190 @@ namespace udo::lexer {
                 (s[current_pos] == 'e' || s[current_pos] == 'E' ||
                  (base == 16 && (s[current_pos] == 'p' || s[current_pos] == 'P')))) {
 
-                char exp_char = s[current_pos++];
-                lexeme += exp_char;
+                ++current_pos;
 
                 // Optional sign
                 if (current_pos < s.size() && (s[current_pos] == '+' || s[current_pos] == '-')) {
-                    lexeme += s[current_pos++];
+                    ++current_pos;
                 }
 
                 // Exponent digits (always decimal, even for hex floats)
                 bool has_exp_digits = false;
                 while (current_pos < s.size()) {
-                    if (std::isdigit(s[current_pos])) {
-                        lexeme += s[current_pos++];
+                    if (is_digit(s[current_pos])) {
+                        current_pos = scanners->digit_end(s.data(), current_pos + 1, s.size());
                         has_exp_digits = true;
-                    } else if (isSeparator(s[current_pos]) && has_exp_digits &&
-                               current_pos + 1 < s.size() && std::isdigit(s[current_pos + 1])) {
-                        lexeme += s[current_pos++];
+                    } else if (is_digit_separator(s[current_pos]) && has_exp_digits &&
+                               current_pos + 1 < s.size() && is_digit(s[current_pos + 1])) {
+                        ++current_pos;
                     } else {
                         break;
                     }
                 }
 
                 if (!has_exp_digits) {
-                    return {TokenType::unknown, s.substr(start, current_pos - start), line_number, column};
+                    return {TokenType::unknown, s.substr(start, current_pos - start)};
                 }
                 is_float = true;
             } else if (needs_exponent) {
                 // Hex float without required 'p' exponent
-                return {TokenType::unknown, s.substr(start, current_pos - start), line_number, column};
+                return {TokenType::unknown, s.substr(start, current_pos - start)};
             }
         }
 
         // Type suffixes
-        std::string suffix;
-        while (current_pos < s.size() && std::isalpha(s[current_pos])) {
-            suffix += s[current_pos++];
+        const std::size_t suffix_start = current_pos;
+        while (current_pos < s.size() && is_alpha(s[current_pos])) {
+            ++current_pos;
         }
+        const std::string_view suffix = s.substr(suffix_start, current_pos - suffix_start);
 
         if (!suffix.empty()) {
-            std::string lower;
-            for (auto c : suffix) {
-                lower += static_cast<char>(std::tolower(c));
-            }
+            auto suffix_is = [suffix](const std::string_view valid) {
+                return std::ranges::equal(suffix, valid, [](const char a, const char b) {
+                    return to_lower(a) == b;
+                });
+            };
 
             // Validate suffix
             if (is_float) {
                 // Float suffixes: f, lf, l (long double)
-                if (lower != "f" && lower != "lf" && lower != "l") {
-                    return {TokenType::unknown, s.substr(start, current_pos - start), line_number, column};
+                constexpr std::string_view validSuffixes[] = {"f", "lf", "l"};
+                if (!std::ranges::any_of(validSuffixes, suffix_is)) {
+                    return {TokenType::unknown, s.substr(start, current_pos - start)};
                 }
             } else {
                 // Integer suffixes: u, l, ul, lu, ll, ull, llu, z, uz, zu
-                constexpr std::string validSuffixes[] = {
+                constexpr std::string_view validSuffixes[] = {
                     "u", "l", "ul", "lu", "ll", "ull", "llu", "z", "uz", "zu"
                 };
-                bool is_valid = false;
-                for (const auto& validSuffix : validSuffixes) {
-                    if (lower == validSuffix) {
-                        is_valid = true;
-                        break;
-                    }
-                }
-                if (!is_valid) {
-                    return {TokenType::unknown, s.substr(start, current_pos - start), line_number, column};
+                if (!std::ranges::any_of(validSuffixes, suffix_is)) {
+                    return {TokenType::unknown, s.substr(start, current_pos - start)};
                 }
             }
-            lexeme += suffix;
         }
 
+        // the digits are still in cache, decode them now so nothing downstream has to parse them again
+        decoded_literal = decode_numeric_literal(s.substr(digits_begin, suffix_start - digits_begin), base, is_float, suffix);
+
         TokenType tok_type = is_float ? TokenType::float_literal : TokenType::int_literal;
-        unfiltered_tokens.push_back({tok_type, spaces + lexeme, line_number, column});
-        spaces.clear();
-        return {tok_type, lexeme, line_number, column};
+        return {tok_type, s.substr(start, current_pos - start)};
     }
 
-    Token Lexer::tokenize_identifier() {
-        int column = static_cast<int>(current_pos) + 1;
-        std::string ident;
+    Lexer::Lexeme Lexer::tokenize_identifier() {
+        const std::size_t start = current_pos;
 
-        while (current_pos < current_line.size() && (std::isalnum(current_line[current_pos]) || current_line[current_pos] == '_')) {
-            ident += current_line[current_pos++];
+        current_pos = scanners->identifier_end(current_line.data(), current_pos, current_line.size());
+
+        // non-ASCII identifier characters are only decoded once the vectorized scan stops on one
+        bool ascii = true;
+        while (current_pos < current_line.size() && !utf8::is_ascii(current_line[current_pos])) {
+            const std::size_t length = unicode_identifier_length(current_line, current_pos);
+            if (length == 0) break;
+            ascii = false;
+            current_pos = scanners->identifier_end(current_line.data(), current_pos + length, current_line.size());
         }
 
-        TokenType type = is_keyword(ident) ? get_keyword_type(ident) : TokenType::identifier;
-        unfiltered_tokens.push_back({type, spaces + ident, line_number, column});
-        spaces.clear();
-        return {type, ident, line_number, column};
+        const std::string_view ident = current_line.substr(start, current_pos - start);
+        // a single perfect-hash probe, falls back to TokenType::identifier for non-keywords
+        return {ascii ? get_keyword_type(ident) : TokenType::identifier, ident};
     }
 
-    Token Lexer::tokenize_symbol() {
-        int column = static_cast<int>(current_pos) + 1;
-
-        for (const auto &sym : symbols) {
-            std::size_t len = sym.size();
-            if (current_pos + len <= current_line.size() &&
-                current_line.substr(current_pos, len) == sym) {
-                current_pos += len;
-                TokenType type = get_symbol_type(sym);
-                unfiltered_tokens.push_back({type, spaces + sym, line_number, column});
-                spaces.clear();
-                return {type, sym, line_number, column};
+    Lexer::Lexeme Lexer::tokenize_symbol() {
+        // longest match and its type come out of a single walk over the symbol trie
+        const std::string_view rest = current_line.substr(current_pos);
+        if (const auto [type, length] = symbol_trie.longest_match(rest); length > 0) {
+            current_pos += length;
+            return {type, rest.substr(0, length)};
+        }
+
+        const std::string_view unknown_char = current_line.substr(current_pos++, 1);
+        return {TokenType::unknown, unknown_char};
+    }
+
+    Lexer::Lexeme Lexer::tokenize_quoted(const char quote) {
+        const std::size_t start = current_pos;
+        const bool is_string = quote == '"';
+        const Run_Scanner find_stop = is_string ? scanners->find_string_stop : scanners->find_char_stop;
+
+        // jump from one quote or backslash to the next, a backslash always takes the character after it along
+        bool escaped = false;
+        bool closed = false;
+        std::size_t pos = start + 1;
+        while ((pos = find_stop(current_line.data(), pos, current_line.size())) < current_line.size()) {
+            if (current_line[pos] == quote) {
+                closed = true;
+                ++pos;
+                break;
             }
+            escaped = true;
+            pos += 2;
+        }
+        current_pos = std::min(pos, current_line.size());
+
+        const std::string_view lexeme = current_line.substr(start, current_pos - start);
+        const std::size_t offset = offset_of(lexeme.data());
+        if (!closed) report(offset, is_string ? diag::lex::err_unterminated_string : diag::lex::err_unterminated_char);
+
+        // literals without escapes are their own contents, only escaped ones are decoded (once, right here)
+        std::string_view contents = string_contents(lexeme);
+        string_escaped = escaped;
+        escaped_string = {};
+        if (escaped) {
+            escape_scratch.clear();
+            if (const std::size_t invalid = decode_escapes(contents, escape_scratch); invalid != std::string_view::npos) {
+                report(offset_of(contents.data() + invalid), diag::lex::err_invalid_escape_sequence);
+            }
+            contents = escape_scratch;
+            if (strings) escaped_string = {strings.store(strings.arena, escape_scratch), escape_scratch.size()};
+        }
+
+        if (!is_string && closed) {
+            const std::size_t length = utf8::count_code_points(contents.data(), contents.size());
+            if (length == 0) report(offset, diag::lex::err_empty_character_literal);
+            else if (length > 1) report(offset, diag::lex::warn_multi_char_constant);
+        }
+        return {is_string ? TokenType::string_literal : TokenType::char_literal, lexeme};
+    }
+
+    Lexer::Lexeme Lexer::tokenize_comment() {
+        const std::size_t start = current_pos;
+        if (current_line[start + 1] == '/') {
+            current_pos = current_line.size();
+            return {TokenType::comment, current_line.substr(start)};
+        }
+
+        // block comments are the only tokens that span lines, so their end is looked for in the whole
+        // source rather than the line (and past the end of the range being lexed)
+        const std::size_t begin = offset_of(current_line.data() + start);
+        std::size_t end = source.find("*/", begin + 2);
+        if (end == std::string_view::npos) {
+            report(begin, diag::lex::err_unterminated_block_comment);
+            end = source.size();
+        } else {
+            end += 2;
+        }
+        continue_at(end);
+        return {TokenType::comment, source.substr(begin, end - begin)};
+    }
+
+    void Lexer::continue_at(const std::size_t pos) {
+        const std::size_t line_start = offset_of(current_line.data());
+        if (pos <= line_end) {
+            current_pos = pos - line_start;
+            return;
         }
 
-        char unknown_char = current_line[current_pos++];
-        unfiltered_tokens.push_back({TokenType::unknown, spaces + std::string(1, unknown_char), line_number, column});
-        spaces.clear();
-        return {TokenType::unknown, std::string(1, unknown_char), line_number, column};
+        const std::size_t new_line_start = source.rfind('\n', pos - 1) + 1;
+        line_end = scanners->find_newline(source.data(), pos, source.size());
+        next_line_start = line_end + 1;
+        range_end = std::max(range_end, std::min(next_line_start, source.size()));
+        current_line = source.substr(new_line_start, line_end - new_line_start);
+        current_pos = pos - new_line_start;
     }
 
     bool Lexer::is_symbol_start(char c) const {
-        return std::ranges::any_of(symbols, [c](const std::string &sym) {
-            return !sym.empty() && sym[0] == c;
-        });
+        return symbol_trie.is_start(c);
     }
 
-} // namespace udo::lexer
\ No newline at end of file
+} // namespace udo::lexer
@@ -10,17 +10,21 @@
 
 
 namespace udo::parse {
-    Token Parser::peek(const int n) const { return tokens[pos + n]; }
+    Token Parser::peek(const int n) const {
+        if (n < 0) return tokens.previous();
+        return tokens.peek(static_cast<std::size_t>(n));
+    }
+
     Token Parser::consume(const int n) {
-        Token token = tokens[pos];
+        Token token = tokens.next_token();
+        for (int i = 1; i < n; ++i) tokens.next_token();
         pos += n;
         return token;
     }
 
     Token Parser::consume_and_expect(const TokenType exp, const Token& curr, const diag::DiagID err) {
         if (curr.type == exp) {
-            pos++;
-            return previous();
+            return consume();
         }
 
         diagnostics_.Report(err)
@@ -41,7 +45,24 @@ namespace udo::parse {
         }
     }
 
-    bool Parser::is_at_end() const { return pos >= tokens.size() || tokens[pos].type == TokenType::eof; }
+    const IdentifierInfo* Parser::get_identifier(const Token& token) {
+        if (token.type != TokenType::identifier) return nullptr;
+        // tokens from a lexer without an identifier table still have to be interned here
+        return token.identifier ? token.identifier : context_.get_identifier_table().get(token.lexeme);
+    }
+
+    std::string_view Parser::get_string(const Token& token) {
+        if (const std::string_view* decoded = tokens.decoded_string(token)) return *decoded;
+
+        // without escapes the contents are the lexeme itself, otherwise the lexer had nowhere to decode them to
+        const std::string_view contents = string_contents(token.lexeme);
+        if (contents.find('\\') == std::string_view::npos) return contents;
+        std::string decoded;
+        decode_escapes(contents, decoded);
+        return {context_.allocate_string(decoded), decoded.size()};
+    }
+
+    bool Parser::is_at_end() const { return tokens.peek().type == TokenType::eof; }
 
     void Parser::parse() {
         for (bool at_eof = parse_first_top_level_decl(); !at_eof; at_eof = is_at_end()) {
@@ -76,15 +97,14 @@ namespace udo::parse {
 
 
         match(initial_let);
-        std::string variable_id =
-            match(variable_identifier).lexeme;
+        const IdentifierInfo* variable_id = get_identifier(match(variable_identifier));
         (void)variable_id;
 
         // attempt to match `=` or `:`
         attempt(colon);
     }
 
-    Parser::Parser(const std::vector<Token> &tokens, Flags flag, ASTContext &context, diag::DiagnosticsEngine& diag)
+    Parser::Parser(TokenSource& tokens, Flags flag, ASTContext &context, diag::DiagnosticsEngine& diag)
         : diagnostics_(diag), context_(context), tokens(tokens), flags(std::move(flag)), parser_context(ParserContext::top_level) {
     }
 
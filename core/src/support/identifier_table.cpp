@@ -0,0 +1,52 @@
+//
+// Created by David Yang on 2026-03-11.
+//
+
+#include <support/identifier_table.hpp>
+
+#include <cstring>
+#include <functional>
+#include <new>
+
+namespace udo {
+
+    const IdentifierInfo* IdentifierTable::get(const std::string_view name) {
+        const std::size_t hash = std::hash<std::string_view>{}(name);
+        Shard& shard = shards[shard_of(hash)];
+
+        std::lock_guard shard_lock(shard.mutex);
+        if (const auto it = shard.names.find(name); it != shard.names.end()) return it->second;
+
+        IdentifierInfo* info;
+        {
+            // the arena is shared by every shard, so it gets a lock of its own
+            std::lock_guard arena_lock(arena_mutex);
+            auto* spelling = static_cast<char*>(allocate_fn(arena, name.size() + 1, 1));
+            std::memcpy(spelling, name.data(), name.size());
+            spelling[name.size()] = '\0';
+
+            void* storage = allocate_fn(arena, sizeof(IdentifierInfo), alignof(IdentifierInfo));
+            info = new (storage) IdentifierInfo(spelling, static_cast<std::uint32_t>(name.size()));
+        }
+
+        shard.names.emplace(info->get_name(), info);
+        return info;
+    }
+
+    const IdentifierInfo* IdentifierTable::find(const std::string_view name) const {
+        const Shard& shard = shards[shard_of(std::hash<std::string_view>{}(name))];
+        std::lock_guard shard_lock(shard.mutex);
+        const auto it = shard.names.find(name);
+        return it != shard.names.end() ? it->second : nullptr;
+    }
+
+    std::size_t IdentifierTable::size() const {
+        std::size_t total = 0;
+        for (const Shard& shard : shards) {
+            std::lock_guard shard_lock(shard.mutex);
+            total += shard.names.size();
+        }
+        return total;
+    }
+
+} // namespace udo
@@ -0,0 +1,61 @@
+//
+// Created by David Yang on 2026-03-16.
+//
+
+#include <support/mapped_file.hpp>
+
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define UDO_HAS_MMAP 1
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace udo {
+
+    Mapped_File::~Mapped_File() {
+#ifdef UDO_HAS_MMAP
+        if (data) munmap(const_cast<char*>(data), size);
+#endif
+    }
+
+    Mapped_File::Mapped_File(Mapped_File &&other) noexcept
+        : data(std::exchange(other.data, nullptr)), size(std::exchange(other.size, 0)) {}
+
+    Mapped_File& Mapped_File::operator=(Mapped_File &&other) noexcept {
+        if (this != &other) {
+            Mapped_File old(std::move(*this));
+            data = std::exchange(other.data, nullptr);
+            size = std::exchange(other.size, 0);
+        }
+        return *this;
+    }
+
+    Mapped_File Mapped_File::open(const std::string &path) {
+        Mapped_File file;
+#ifdef UDO_HAS_MMAP
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return file;
+
+        struct stat info{};
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            const auto length = static_cast<std::size_t>(info.st_size);
+            // nothing is ever written through the mapping, MAP_PRIVATE just keeps the file itself out of reach
+            if (void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0); mapping != MAP_FAILED) {
+                madvise(mapping, length, MADV_SEQUENTIAL);
+                file.data = static_cast<const char*>(mapping);
+                file.size = length;
+            }
+        }
+        // the mapping holds its own reference to the file
+        close(fd);
+#else
+        (void)path;
+#endif
+        return file;
+    }
+
+} // namespace udo
@@ -5,110 +5,484 @@
 #include <support/source_manager.hpp>
 #include <error/error.hpp>
 #include <support/global_constants.hpp>
+#include <support/utf8.hpp>
 
 #include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <limits>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define UDO_HAS_STAT 1
+    #include <sys/stat.h>
+#endif
+
+// SSE2 is part of the x86-64 baseline, so like the UTF-8 helpers this needs no runtime dispatch
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+    #define UDO_LINES_SSE2 1
+    #include <emmintrin.h>
+#endif
 
 namespace udo {
 
+    namespace {
+
+#ifdef UDO_LINES_SSE2
+        std::uint32_t newline_mask(const char* data) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+        }
+#endif
+
+        std::size_t count_newlines(const std::string_view text) {
+            std::size_t count = 0;
+            std::size_t pos = 0;
+#ifdef UDO_LINES_SSE2
+            for (; pos + 16 <= text.size(); pos += 16) count += std::popcount(newline_mask(text.data() + pos));
+#endif
+            for (; pos < text.size(); ++pos) count += text[pos] == '\n';
+            return count;
+        }
+
+        /// append the offset just past every newline in `text`
+        void append_line_starts(const std::string_view text, std::vector<std::size_t> &line_starts) {
+            std::size_t pos = 0;
+#ifdef UDO_LINES_SSE2
+            for (; pos + 16 <= text.size(); pos += 16) {
+                for (std::uint32_t mask = newline_mask(text.data() + pos); mask != 0; mask &= mask - 1) {
+                    line_starts.push_back(pos + std::countr_zero(mask) + 1);
+                }
+            }
+#endif
+            for (; pos < text.size(); ++pos) {
+                if (text[pos] == '\n') line_starts.push_back(pos + 1);
+            }
+        }
+
+        /// `path` made absolute with every symlink and `.`/`..` resolved, so each file has one spelling
+        std::string canonical_path(const std::string &path) {
+            std::error_code error;
+            std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+            return error ? path : canonical.string();
+        }
+
+        /// map or read the file at `path`
+        /// @returns nullptr if it cannot be opened
+        std::shared_ptr<const File_Contents> read_file(const std::string &path) {
+            std::ifstream file(path, std::ios::binary);
+            if (!file.is_open()) return nullptr;
+
+            auto contents = std::make_shared<File_Contents>();
+            contents->mapping = Mapped_File::open(path);
+            if (!contents->mapping) {
+                // empty, not a regular file, or no mmap on this platform
+                contents->data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            }
+            return contents;
+        }
+
+    } // namespace
+
     Buffer::Buffer(const std::string &data, const std::string &path)
         : data(data), path(path) {}
 
+    std::string& Buffer::make_owned() {
+        if (contents) {
+            data.assign(contents->text());
+            contents.reset();
+        }
+        // the contents are about to stop matching the file
+        on_disk = false;
+        return data;
+    }
+
     void Buffer::compute_line_starts() {
+        // counted first so the table is allocated at its exact size, one entry per line
+        const std::string_view contents = text();
         line_starts.clear();
-        line_starts.reserve(data.size());
+        line_starts.shrink_to_fit();
+        line_starts.reserve(count_newlines(contents) + 1);
         line_starts.push_back(0);
-
-        for (size_t i = 0; i < data.size(); ++i) {
-            if (data[i] == '\n') {
-                line_starts.push_back(i + 1);
-            }
-        }
+        append_line_starts(contents, line_starts);
+        last_line = 0;
         computed = true;
     }
 
+    std::size_t Buffer::validate_utf8() {
+        const std::string_view contents = text();
+        const auto [first_invalid, is_ascii] = utf8::validate(contents.data(), contents.size());
+        ascii = is_ascii && first_invalid == contents.size();
+        encoding_checked = true;
+        return first_invalid;
+    }
+
     std::pair<Line, Column> Buffer::get_line_column(const Offset offset) {
         if (!computed) compute_line_starts();
-        if (offset >= data.size()) return {line_starts.size(), (data.empty() ? 1 : (data.size() - line_starts.back() + 1))};
+        if (!encoding_checked) validate_utf8();
+        const std::string_view contents = text();
+
+        // columns count code points, only counted out (and only on the one line) when the buffer is not plain ASCII
+        const auto column = [this, contents](const std::size_t line_start, const std::size_t end) -> Column {
+            if (ascii) return end - line_start + 1;
+            return utf8::count_code_points(contents.data() + line_start, end - line_start) + 1;
+        };
+
+        if (offset >= contents.size()) return {line_starts.size(), (contents.empty() ? 1 : column(line_starts.back(), contents.size()))};
 
-        auto it = std::upper_bound(line_starts.begin(), line_starts.end(), offset);
-        if (it == line_starts.begin()) return {0, offset};
-        --it;
-        return {(std::distance(line_starts.begin(), it) + 1), (offset - *it + 1)}; // add one because it's 1-based
+        // diagnostics tend to come in runs on the same line, so only search when the last one misses
+        std::size_t line = last_line;
+        if (offset < line_starts[line] || (line + 1 < line_starts.size() && offset >= line_starts[line + 1])) {
+            line = std::upper_bound(line_starts.begin(), line_starts.end(), offset) - line_starts.begin() - 1;
+            last_line = line;
+        }
+        return {line + 1, column(line_starts[line], offset)}; // add one because it's 1-based
     }
 
     std::string Buffer::get_line_text(const Line line_no) {
         if (!computed) compute_line_starts();
         if (line_no == 0 || line_no > line_starts.size()) return "";
+        const std::string_view contents = text();
         std::size_t start = line_starts[line_no - 1];
         std::size_t end;
         if (line_no < line_starts.size()) end = line_starts[line_no] - 1;   // can't access the last element
-        else end = data.size() - 1;                                         // actual logic for last line
-        return data.substr(start, end - start + 1);
+        else end = contents.size() - 1;                                     // actual logic for last line
+        return std::string(contents.substr(start, end - start + 1));
+    }
+
+    FileID Source_Manager::add(Buffer buffer) {
+        // one past the end of the contents still belongs to the file, that is where its eof token is
+        const std::uint64_t end = static_cast<std::uint64_t>(next_offset_) + buffer.text().size() + 1;
+        if (end > std::numeric_limits<Offset>::max()) return SOURCE_MANAGER_INVALID_FILE_ID;
+
+        buffer.start = next_offset_;
+        buffer.slice_size = static_cast<std::size_t>(end - next_offset_);
+        next_offset_ = static_cast<Offset>(end);
+        return static_cast<FileID>(buffers.emplace_back(std::move(buffer)) + 1);
     }
 
     FileID Source_Manager::add_buffer(std::string content, std::string path) {
-        Buffer b(std::move(content), std::move(path));
-        b.compute_line_starts();
-        FileID id = next_file_id_++;
-        buffers[id] = std::move(b);
-        return id;
+        Buffer buffer(std::move(content), std::move(path));
+        std::lock_guard lock(add_mutex);
+        return add(std::move(buffer));
+    }
+
+    bool Source_Manager::stat_file(const std::string &path, File_Status &status) {
+#ifdef UDO_HAS_STAT
+        struct stat info{};
+        if (stat(path.c_str(), &info) != 0) return false;
+    #ifdef __APPLE__
+        const timespec mtime = info.st_mtimespec;
+    #else
+        const timespec mtime = info.st_mtim;
+    #endif
+        status = {static_cast<std::uint64_t>(info.st_dev), static_cast<std::uint64_t>(info.st_ino),
+                  static_cast<std::uint64_t>(info.st_size),
+                  static_cast<std::int64_t>(mtime.tv_sec) * 1'000'000'000 + mtime.tv_nsec};
+#else
+        std::error_code error;
+        const auto size = std::filesystem::file_size(path, error);
+        if (error) return false;
+        const auto mtime = std::filesystem::last_write_time(path, error);
+        if (error) return false;
+        status = {0, 0, static_cast<std::uint64_t>(size), static_cast<std::int64_t>(mtime.time_since_epoch().count())};
+#endif
+        return true;
+    }
+
+    void File_Load::report(diag::DiagnosticsEngine &diag) const {
+        if (!diagnostic) return;
+        auto builder = diag.Report(location, *diagnostic);
+        // problems with the file as a whole have no location and name the path instead
+        if (location.isInvalid()) builder << path;
     }
 
     FileID Source_Manager::add_file_from_disk(const std::string &path, udo::diag::DiagnosticsEngine &diag) {
-        std::ifstream file(path, std::ios::binary);
-        if (!file.is_open()) {
-            diag.Report(Source_Location{}, diag::common::err_file_not_found)
-                << path;
-            return SOURCE_MANAGER_INVALID_FILE_ID;
+        const File_Load load = load_file(path);
+        load.report(diag);
+        return load.id;
+    }
+
+    File_Load Source_Manager::load_file(const std::string &path) {
+        File_Load load;
+        load.path = path;
+
+        std::string canonical = canonical_path(path);
+        {
+            std::lock_guard lock(add_mutex);
+            if (const auto overlay = overlays.find(canonical); overlay != overlays.end()) {
+                load_overlay(load, canonical, overlay->second);
+                return load;
+            }
+        }
+
+        File_Status status;
+        const bool has_status = stat_file(canonical, status);
+        if (has_status) {
+            std::scoped_lock lock(add_mutex, lines_mutex);
+            if (const auto it = file_entries.find(canonical); it != file_entries.end() && it->second.generation == 0
+                && it->second.status == status && retain_locked(it->second.id)) {
+                load.id = it->second.id;
+                return load;
+            }
+        }
+
+        // the file is read, hashed and validated before taking the lock, so threads loading different
+        // files only wait for each other to append
+        Buffer buffer;
+        buffer.path = path;
+        buffer.contents = read_file(path);
+        if (!buffer.contents) {
+            load.id = SOURCE_MANAGER_INVALID_FILE_ID;
+            load.diagnostic = diag::common::err_file_not_found;
+            return load;
+        }
+
+        const std::size_t hash = std::hash<std::string_view>{}(buffer.text());
+        buffer.hash = hash;
+        buffer.on_disk = true;
+        buffer.uses = 1;
+        // checked once up front, so later column lookups already know whether the file is plain ASCII.
+        // Line starts are left to the first lookup that needs them, so opening never scans the file twice.
+        const std::size_t invalid = buffer.validate_utf8();
+        const bool valid = invalid == buffer.text().size();
+
+        std::lock_guard lock(add_mutex);
+        // a copy of a file that is already loaded (e.g. the same module vendored twice) still gets a buffer
+        // and FileID of its own, so it is reported under its own path, but holds on to the loaded contents
+        // instead of its own. Released buffers may be evicted at any moment, so they are left alone
+        for (auto [it, end] = content_ids.equal_range(hash); it != end; ++it) {
+            const Buffer& loaded = buffers[it->second - 1];
+            if (!loaded.released && loaded.contents && loaded.text() == buffer.text()) {
+                buffer.contents = loaded.contents;
+                break;
+            }
         }
 
-        std::string content((std::istreambuf_iterator<char>(file)),
-                            std::istreambuf_iterator<char>());
-        file.close();
+        load.id = add(std::move(buffer));
+        if (load.id == static_cast<FileID>(SOURCE_MANAGER_INVALID_FILE_ID)) {
+            load.diagnostic = diag::common::err_file_too_large;
+            return load;
+        }
+        content_ids.emplace(hash, load.id);
+        if (!valid) {
+            load.diagnostic = diag::lex::err_invalid_utf8;
+            load.location = get_location(load.id, invalid);
+        }
 
-        return add_buffer(std::move(content), path);
+        if (has_status) file_entries.insert_or_assign(std::move(canonical), File_Entry{status, load.id});
+        return load;
     }
 
-    Buffer* Source_Manager::getBuffer(FileID id) {
-        auto it = buffers.find(id);
-        if (it != buffers.end()) {
-            return &it->second;
+    void Source_Manager::set_cache_limit(const std::size_t bytes) {
+        std::lock_guard lock(lines_mutex);
+        cache_limit = bytes;
+        evict_to_limit();
+    }
+
+    void Source_Manager::release(const FileID id) {
+        Buffer* buffer = getBuffer(id);
+        // `released` is read under add_mutex when looking for a buffer to share, so both are taken
+        std::scoped_lock lock(add_mutex, lines_mutex);
+        if (!buffer || buffer->uses == 0) return;
+        // another load of the same file may still be lexing it
+        if (--buffer->uses != 0 || !buffer->on_disk) return;
+
+        buffer->released = true;
+        released_at.emplace(id, released_files.insert(released_files.end(), id));
+        released_bytes += buffer->text().size();
+        evict_to_limit();
+    }
+
+    void Source_Manager::evict_to_limit(const FileID keep) const {
+        while (cache_limit != 0 && released_bytes > cache_limit && !released_files.empty()
+               && released_files.front() != keep) {
+            const FileID id = released_files.front();
+            released_files.pop_front();
+            released_at.erase(id);
+
+            auto& buffer = const_cast<Buffer&>(buffers[id - 1]);
+            released_bytes -= buffer.text().size();
+            // contents shared with a buffer still in use stay alive through it
+            buffer.contents.reset();
+            std::vector<std::size_t>().swap(buffer.line_starts);
+            buffer.computed = false;
+            buffer.evicted = true;
         }
-        return nullptr;
     }
 
-    const Buffer* Source_Manager::getBuffer(FileID id) const {
-        auto it = buffers.find(id);
-        if (it != buffers.end()) {
-            return &it->second;
+    bool Source_Manager::make_resident(const FileID id) const {
+        auto& buffer = const_cast<Buffer&>(buffers[id - 1]);
+        if (!buffer.released) return true;
+
+        if (!buffer.evicted) {
+            // most recently used now
+            released_files.splice(released_files.end(), released_files, released_at.at(id));
+            return true;
         }
-        return nullptr;
+
+        auto reread = read_file(buffer.path);
+        // anything else would put locations and lines out of step with what was lexed
+        if (!reread || std::hash<std::string_view>{}(reread->text()) != buffer.hash) return false;
+        buffer.contents = std::move(reread);
+        buffer.evicted = false;
+
+        released_at.emplace(id, released_files.insert(released_files.end(), id));
+        released_bytes += buffer.text().size();
+        evict_to_limit(id);
+        return true;
+    }
+
+    bool Source_Manager::retain(const FileID id) {
+        if (!getBuffer(id)) return false;
+        std::scoped_lock lock(add_mutex, lines_mutex);
+        return retain_locked(id);
+    }
+
+    bool Source_Manager::retain_locked(const FileID id) {
+        Buffer& buffer = buffers[id - 1];
+        if (buffer.released) {
+            if (!make_resident(id)) return false;
+
+            released_files.erase(released_at.at(id));
+            released_at.erase(id);
+            released_bytes -= buffer.text().size();
+            buffer.released = false;
+        }
+        ++buffer.uses;
+        return true;
+    }
+
+    void Source_Manager::load_overlay(File_Load &load, const std::string &canonical, const Overlay &overlay) {
+        if (const auto it = file_entries.find(canonical); it != file_entries.end() && it->second.generation == overlay.generation) {
+            load.id = it->second.id;
+            ++buffers[load.id - 1].uses;
+            return;
+        }
+
+        // a new generation gets a buffer of its own, locations into the old one stay valid. Overlays are
+        // not on disk, so they are never evicted, and not hashed, so nothing shares them
+        Buffer buffer(overlay.contents, load.path);
+        buffer.uses = 1;
+        const std::size_t invalid = buffer.validate_utf8();
+        const bool valid = invalid == buffer.text().size();
+        load.id = add(std::move(buffer));
+        if (load.id == static_cast<FileID>(SOURCE_MANAGER_INVALID_FILE_ID)) {
+            load.diagnostic = diag::common::err_file_too_large;
+            return;
+        }
+        if (!valid) {
+            load.diagnostic = diag::lex::err_invalid_utf8;
+            load.location = get_location(load.id, invalid);
+        }
+        file_entries.insert_or_assign(canonical, File_Entry{{}, load.id, overlay.generation});
+    }
+
+    std::uint64_t Source_Manager::set_overlay(const std::string &path, std::string contents) {
+        std::string canonical = canonical_path(path);
+        std::lock_guard lock(add_mutex);
+        const std::uint64_t generation = next_generation_++;
+        overlays.insert_or_assign(std::move(canonical), Overlay{std::move(contents), generation});
+        return generation;
+    }
+
+    void Source_Manager::remove_overlay(const std::string &path) {
+        const std::string canonical = canonical_path(path);
+        std::lock_guard lock(add_mutex);
+        overlays.erase(canonical);
+    }
+
+    std::uint64_t Source_Manager::overlay_generation(const std::string &path) const {
+        const std::string canonical = canonical_path(path);
+        std::lock_guard lock(add_mutex);
+        const auto it = overlays.find(canonical);
+        return it != overlays.end() ? it->second.generation : 0;
+    }
+
+    FileID Source_Manager::find_file(const std::string &path) const {
+        const std::string canonical = canonical_path(path);
+        std::lock_guard lock(add_mutex);
+        const auto it = file_entries.find(canonical);
+        return it != file_entries.end() ? it->second.id : 0;
+    }
+
+    Buffer* Source_Manager::getBuffer(const FileID id) {
+        return id == 0 ? nullptr : buffers.find(id - 1);
+    }
+
+    const Buffer* Source_Manager::getBuffer(const FileID id) const {
+        return id == 0 ? nullptr : buffers.find(id - 1);
+    }
+
+    Source_Location Source_Manager::get_location(const FileID id, const std::size_t offset) const {
+        const Buffer* buffer = getBuffer(id);
+        return buffer ? Source_Location(static_cast<Offset>(buffer->start + offset)) : Source_Location{};
+    }
+
+    FileID Source_Manager::get_file_id(const Source_Location loc) const {
+        const std::size_t count = buffers.size();
+        if (loc.isInvalid() || count == 0) return 0;
+
+        const auto holds = [this, loc, count](const FileID id) {
+            return loc.offset >= buffers[id - 1].start && (id == count || loc.offset < buffers[id].start);
+        };
+        // diagnostics come in runs against the same file, so the last hit is checked before searching
+        if (const FileID last = last_file_.load(std::memory_order_relaxed); last != 0 && last <= count && holds(last)) {
+            return last;
+        }
+
+        // the first file starting past `loc`, the one before it holds `loc`
+        std::size_t low = 0, high = count;
+        while (low < high) {
+            const std::size_t mid = low + (high - low) / 2;
+            if (buffers[mid].start <= loc.offset) low = mid + 1;
+            else high = mid;
+        }
+        const auto id = static_cast<FileID>(low);
+        last_file_.store(id, std::memory_order_relaxed);
+        return id;
+    }
+
+    const Buffer* Source_Manager::find_buffer(const Source_Location loc) const {
+        return getBuffer(get_file_id(loc));
+    }
+
+    Offset Source_Manager::get_file_offset(const Source_Location loc) const {
+        const Buffer* buf = find_buffer(loc);
+        return buf ? loc.offset - buf->start : 0;
     }
 
     std::pair<Line, Column> Source_Manager::getLineColumn(Source_Location loc) const {
-        const Buffer* buf = getBuffer(loc.file);
+        const FileID id = get_file_id(loc);
+        const Buffer* buf = getBuffer(id);
         if (!buf) {
             return {0, 0};
         }
-        // Need a non-const version for get_line_column
-        return const_cast<Buffer*>(buf)->get_line_column(loc.offset);
+        // line tables are built and cached on first use
+        std::lock_guard lock(lines_mutex);
+        if (!make_resident(id)) return {0, 0};
+        return const_cast<Buffer*>(buf)->get_line_column(loc.offset - buf->start);
     }
 
     std::string Source_Manager::getLineText(Source_Location loc) const {
-        const Buffer* buf = getBuffer(loc.file);
+        const FileID id = get_file_id(loc);
+        const Buffer* buf = getBuffer(id);
         if (!buf) {
             return "";
         }
-        auto [line, col] = const_cast<Buffer*>(buf)->get_line_column(loc.offset);
+        std::lock_guard lock(lines_mutex);
+        if (!make_resident(id)) return "";
+        auto [line, col] = const_cast<Buffer*>(buf)->get_line_column(loc.offset - buf->start);
         return const_cast<Buffer*>(buf)->get_line_text(line);
     }
 
     std::string Source_Manager::getFilePath(Source_Location loc) const {
-        const Buffer* buf = getBuffer(loc.file);
+        const Buffer* buf = find_buffer(loc);
         if (!buf) {
             return "";
         }
         return buf->path;
     }
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,97 @@
+//
+// Created by David Yang on 2026-03-19.
+//
+
+#include <support/source_prefetcher.hpp>
+#include <support/global_constants.hpp>
+
+namespace udo {
+
+    Source_Prefetcher::Source_Prefetcher(Source_Manager &sources, const std::size_t memory_budget)
+        : sources(sources), budget(memory_budget), worker([this] { run(); }) {}
+
+    Source_Prefetcher::~Source_Prefetcher() {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        changed.notify_all();
+        worker.join();
+    }
+
+    void Source_Prefetcher::enqueue(const std::string &path) {
+        {
+            std::lock_guard lock(mutex);
+            if (!index.try_emplace(path, entries.size()).second) return;
+            entries.emplace_back().path = path;
+        }
+        changed.notify_all();
+    }
+
+    File_Load Source_Prefetcher::take(const std::string &path) {
+        std::unique_lock lock(mutex);
+        const auto it = index.find(path);
+        if (it == index.end()) {
+            lock.unlock();
+            return sources.load_file(path);
+        }
+
+        Entry& entry = entries[it->second];
+        if (entry.state == State::queued) {
+            // waiting on the background thread would only add latency, it would start on it just the same
+            entry.state = State::loading;
+            lock.unlock();
+            File_Load load = sources.load_file(path);
+            lock.lock();
+            entry.load = load;
+            entry.state = State::taken;
+            lock.unlock();
+            changed.notify_all();
+            return load;
+        }
+
+        changed.wait(lock, [&entry] { return entry.state != State::loading; });
+        if (entry.state == State::ready) {
+            entry.state = State::taken;
+            held -= entry.bytes;
+            lock.unlock();
+            changed.notify_all();
+            return entry.load;
+        }
+
+        // handed out before, and maybe released since, so it counts as another use like a second
+        // load_file would. One whose contents changed on disk after eviction is loaded afresh
+        File_Load load = entry.load;
+        lock.unlock();
+        if (load.id == 0 || load.id == static_cast<FileID>(SOURCE_MANAGER_INVALID_FILE_ID) || sources.retain(load.id)) {
+            return load;
+        }
+        return sources.load_file(path);
+    }
+
+    void Source_Prefetcher::run() {
+        std::unique_lock lock(mutex);
+        for (;;) {
+            // always let one file through when nothing is held, however large it is
+            changed.wait(lock, [this] { return stopping || (next < entries.size() && (held < budget || held == 0)); });
+            if (stopping) return;
+
+            Entry& entry = entries[next++];
+            if (entry.state != State::queued) continue;     // taken before we got to it
+            entry.state = State::loading;
+
+            lock.unlock();
+            File_Load load = sources.load_file(entry.path);
+            const Buffer* buffer = sources.getBuffer(load.id);
+            const std::size_t bytes = buffer ? buffer->text().size() : 0;
+            lock.lock();
+
+            entry.load = std::move(load);
+            entry.bytes = bytes;
+            entry.state = State::ready;
+            held += bytes;
+            changed.notify_all();
+        }
+    }
+
+} // namespace udo
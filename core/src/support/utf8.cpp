@@ -0,0 +1,137 @@
+//
+// Created by David Yang on 2026-03-14.
+//
+
+#include <support/utf8.hpp>
+
+#include <bit>
+#include <cstdint>
+
+// SSE2 is part of the x86-64 baseline, so unlike the lexer scanners this needs no runtime dispatch
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+    #define UDO_UTF8_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+namespace udo::utf8 {
+
+    namespace {
+
+        constexpr bool is_continuation(const unsigned char c) { return (c & 0xC0) == 0x80; }
+
+    } // namespace
+
+    std::size_t decode(const char* data, const std::size_t size, char32_t& code_point) {
+        if (size == 0) return 0;
+        const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+        const unsigned char lead = bytes[0];
+
+        if (lead < 0x80) {
+            code_point = lead;
+            return 1;
+        }
+
+        // length and the valid range of the second byte, which is where overlong forms,
+        // surrogates and code points past U+10FFFF are ruled out
+        std::size_t length;
+        unsigned char second_lo = 0x80, second_hi = 0xBF;
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            length = 2;
+            code_point = lead & 0x1F;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            length = 3;
+            code_point = lead & 0x0F;
+            if (lead == 0xE0) second_lo = 0xA0;
+            if (lead == 0xED) second_hi = 0x9F;
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            length = 4;
+            code_point = lead & 0x07;
+            if (lead == 0xF0) second_lo = 0x90;
+            if (lead == 0xF4) second_hi = 0x8F;
+        } else {
+            return 0;
+        }
+
+        if (size < length || bytes[1] < second_lo || bytes[1] > second_hi) return 0;
+        for (std::size_t i = 1; i < length; ++i) {
+            if (!is_continuation(bytes[i])) return 0;
+            code_point = code_point << 6 | (bytes[i] & 0x3F);
+        }
+        return length;
+    }
+
+    std::size_t encode(const char32_t code_point, char* out) {
+        if (code_point < 0x80) {
+            out[0] = static_cast<char>(code_point);
+            return 1;
+        }
+        if (code_point < 0x800) {
+            out[0] = static_cast<char>(0xC0 | code_point >> 6);
+            out[1] = static_cast<char>(0x80 | (code_point & 0x3F));
+            return 2;
+        }
+        if (code_point < 0x10000) {
+            out[0] = static_cast<char>(0xE0 | code_point >> 12);
+            out[1] = static_cast<char>(0x80 | (code_point >> 6 & 0x3F));
+            out[2] = static_cast<char>(0x80 | (code_point & 0x3F));
+            return 3;
+        }
+        out[0] = static_cast<char>(0xF0 | code_point >> 18);
+        out[1] = static_cast<char>(0x80 | (code_point >> 12 & 0x3F));
+        out[2] = static_cast<char>(0x80 | (code_point >> 6 & 0x3F));
+        out[3] = static_cast<char>(0x80 | (code_point & 0x3F));
+        return 4;
+    }
+
+    std::size_t ascii_end(const char* data, std::size_t pos, const std::size_t end) {
+#ifdef UDO_UTF8_SSE2
+        while (pos + 16 <= end) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+            // the high bit of every byte is exactly the non-ASCII mask
+            if (const auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(v)); mask != 0) {
+                return pos + std::countr_zero(mask);
+            }
+            pos += 16;
+        }
+#endif
+        while (pos < end && is_ascii(data[pos])) ++pos;
+        return pos;
+    }
+
+    Validation validate(const char* data, const std::size_t size) {
+        bool ascii = true;
+        std::size_t pos = 0;
+        for (;;) {
+            pos = ascii_end(data, pos, size);
+            if (pos == size) return {size, ascii};
+
+            // non-ASCII text tends to come in runs, decode the whole run before going back to the fast path
+            ascii = false;
+            do {
+                char32_t code_point;
+                const std::size_t length = decode(data + pos, size - pos, code_point);
+                if (length == 0) return {pos, false};
+                pos += length;
+            } while (pos < size && !is_ascii(data[pos]));
+        }
+    }
+
+    std::size_t count_code_points(const char* data, const std::size_t size) {
+        std::size_t count = 0;
+        std::size_t pos = 0;
+#ifdef UDO_UTF8_SSE2
+        while (pos + 16 <= size) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+            // continuation bytes 0x80-0xBF are exactly the signed bytes below -64
+            const __m128i continuation = _mm_cmplt_epi8(v, _mm_set1_epi8(-64));
+            count += 16 - std::popcount(static_cast<std::uint32_t>(_mm_movemask_epi8(continuation)));
+            pos += 16;
+        }
+#endif
+        for (; pos < size; ++pos) {
+            if (!is_continuation(static_cast<unsigned char>(data[pos]))) ++count;
+        }
+        return count;
+    }
+
+} // namespace udo::utf8
@@ -0,0 +1,134 @@
+//
+// AST Allocator Benchmark
+// Created by David Yang on 2026-03-20.
+//
+// Times node-sized BumpPtrAllocator allocations after the allocator has been left with a growing number
+// of partially used slabs, none with room for the nodes, reporting nanoseconds per allocation as JSON
+// lines or CSV. The cost should stay flat however many slabs there are.
+//
+// Usage: ast_alloc_bench [--slabs=1,64,1024,16384,65536] [--allocs=1000000] [--node-size=48]
+//                        [--repeat=3] [--format=json|csv]
+//
+
+#include <ast/ASTContext.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace udo::bench {
+
+using udo::ast::ASTContext;
+
+constexpr std::size_t slab_size = 1024;
+constexpr std::size_t leftover = 16;            // room left in every filler slab, less than any node
+
+volatile std::uintptr_t sink;
+
+struct Bench_Options {
+    std::vector<std::size_t> slab_counts{1, 64, 1024, 16384, 65536};
+    std::size_t allocs = 1'000'000;
+    std::size_t node_size = 48;
+    unsigned repeat = 3;
+    bool csv = false;
+};
+
+struct Bench_Result {
+    std::size_t slabs;              // partially used slabs left behind before timing
+    std::size_t allocs;
+    double best_seconds;            // fastest of the repeats, the least disturbed by the rest of the machine
+    double median_seconds;
+};
+
+Bench_Result run(const std::size_t slab_count, const Bench_Options& options) {
+    Bench_Result result{slab_count, options.allocs, 0, 0};
+    std::vector<double> seconds;
+    for (unsigned i = 0; i < std::max(options.repeat, 1u); ++i) {
+        ASTContext::BumpPtrAllocator allocator(slab_size);
+        for (std::size_t s = 0; s < slab_count; ++s) allocator.allocate(slab_size - leftover);
+
+        std::uintptr_t checksum = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t n = 0; n < options.allocs; ++n) {
+            checksum ^= reinterpret_cast<std::uintptr_t>(allocator.allocate(options.node_size));
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        sink = checksum;    // keeps the loop from being optimized away
+        seconds.push_back(std::chrono::duration<double>(stop - start).count());
+    }
+
+    std::ranges::sort(seconds);
+    result.best_seconds = seconds.front();
+    result.median_seconds = seconds[seconds.size() / 2];
+    return result;
+}
+
+void report(const Bench_Result& result, const bool csv) {
+    const double ns_per_alloc = result.best_seconds * 1e9 / static_cast<double>(result.allocs);
+
+    if (csv) {
+        std::printf("%zu,%zu,%.6f,%.6f,%.2f\n", result.slabs, result.allocs, result.best_seconds,
+                    result.median_seconds, ns_per_alloc);
+    } else {
+        std::printf("{\"bench\":\"ast.allocate\",\"partial_slabs\":%zu,\"allocs\":%zu,\"best_s\":%.6f,"
+                    "\"median_s\":%.6f,\"ns_per_alloc\":%.2f}\n",
+                    result.slabs, result.allocs, result.best_seconds, result.median_seconds, ns_per_alloc);
+    }
+    std::fflush(stdout);
+}
+
+bool parse_options(const int argc, char* argv[], Bench_Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg.starts_with("--slabs=")) {
+            options.slab_counts.clear();
+            std::string_view list = arg.substr(8);
+            while (!list.empty()) {
+                const std::size_t comma = std::min(list.find(','), list.size());
+                options.slab_counts.push_back(std::strtoull(std::string(list.substr(0, comma)).c_str(), nullptr, 10));
+                list.remove_prefix(std::min(comma + 1, list.size()));
+            }
+        } else if (arg.starts_with("--allocs=")) {
+            options.allocs = std::max<std::size_t>(std::strtoull(argv[i] + 9, nullptr, 10), 1);
+        } else if (arg.starts_with("--node-size=")) {
+            options.node_size = std::strtoull(argv[i] + 12, nullptr, 10);
+            if (options.node_size <= leftover || options.node_size >= slab_size) {
+                std::cerr << "node sizes must be between " << leftover + 1 << " and " << slab_size - 1 << "\n";
+                return false;
+            }
+        } else if (arg.starts_with("--repeat=")) {
+            options.repeat = static_cast<unsigned>(std::strtoul(argv[i] + 9, nullptr, 10));
+        } else if (arg == "--format=csv") {
+            options.csv = true;
+        } else if (arg == "--format=json") {
+            options.csv = false;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--slabs=1,64,1024,16384,65536] [--allocs=1000000]"
+                      << " [--node-size=48] [--repeat=3] [--format=json|csv]\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace udo::bench
+
+int main(const int argc, char* argv[]) {
+    using namespace udo::bench;
+
+    Bench_Options options;
+    if (!parse_options(argc, argv, options)) return 1;
+
+    if (options.csv) {
+        std::printf("partial_slabs,allocs,best_s,median_s,ns_per_alloc\n");
+    }
+    for (const std::size_t slabs : options.slab_counts) report(run(slabs, options), options.csv);
+    return 0;
+}
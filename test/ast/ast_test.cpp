@@ -6,6 +6,9 @@
 #include "ast_test.hpp"
 #include <ast/ast.hpp>
 #include <ast/ASTContext.hpp>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace udo::test {
 
@@ -46,6 +49,20 @@ void register_ast_tests(TestRunner& runner) {
         UDO_ASSERT_EQ(count, 2);
     });
 
+    node_suite->add_test("compound_stmt_larger_than_a_slab", []() {
+        using namespace udo::ast;
+        ASTContext context(4096);
+
+        // 50k statements need far more than one 4 KB slab for the trailing array
+        Stmt* s = context.create<Stmt>(Stmt::Kind::ExprStmt);
+        std::vector<Stmt*> stmts(50'000, s);
+        CompoundStmt* cs = CompoundStmt::create(context, stmts.data(), static_cast<std::uint32_t>(stmts.size()));
+
+        UDO_ASSERT_NOT_NULL(cs);
+        UDO_ASSERT_EQ(cs->size(), 50'000u);
+        UDO_ASSERT_EQ(cs->get_stmts()[49'999], s);
+    });
+
     node_suite->add_test("decl_context_linked_list", []() {
         using namespace udo::ast;
         ASTContext context;
@@ -170,6 +187,129 @@ void register_ast_tests(TestRunner& runner) {
         UDO_ASSERT_EQ(allocator.num_slabs(), 3); // No new slab needed.
     });
 
+    context_suite->add_test("partially_used_slabs_bucketed_by_room_left", [] {
+        using namespace udo::ast;
+        ASTContext::BumpPtrAllocator allocator(64);
+
+        // every slab ends up with 16 bytes left, too few for the next 48
+        for (int i = 0; i < 100; ++i) UDO_ASSERT_NOT_NULL(allocator.allocate(48));
+        UDO_ASSERT_EQ(allocator.num_slabs(), 100);
+        UDO_ASSERT_EQ(allocator.num_partially_used_slabs(), 99);
+
+        // small allocations fill the leftovers, and a full slab leaves the buckets
+        UDO_ASSERT_NOT_NULL(allocator.allocate(16));
+        UDO_ASSERT_EQ(allocator.num_slabs(), 100);
+        UDO_ASSERT_EQ(allocator.num_partially_used_slabs(), 98);
+        UDO_ASSERT_NOT_NULL(allocator.allocate(8));
+        UDO_ASSERT_EQ(allocator.num_partially_used_slabs(), 98);
+
+        // a reset slab moves to the bucket for its whole capacity
+        allocator.reset_slab(42);
+        UDO_ASSERT_EQ(allocator.num_partially_used_slabs(), 98);
+        UDO_ASSERT_NOT_NULL(allocator.allocate(64));
+        UDO_ASSERT_EQ(allocator.num_slabs(), 100);
+        UDO_ASSERT_EQ(allocator.num_partially_used_slabs(), 97);
+    });
+
+    context_suite->add_test("large_allocations_get_their_own_slab", [] {
+        using namespace udo::ast;
+        ASTContext::BumpPtrAllocator allocator(64);
+
+        void* small = allocator.allocate(16);
+        void* large = allocator.allocate(1000);
+        UDO_ASSERT_NOT_NULL(large);
+        UDO_ASSERT_EQ(allocator.num_slabs(), 1);
+        UDO_ASSERT_EQ(allocator.num_large_slabs(), 1);
+        UDO_ASSERT_EQ(allocator.num_allocated_bytes(), 64 + 1000);
+        UDO_ASSERT_EQ(allocator.num_allocated_bytes_used(), 16 + 1000);
+
+        // the current slab was not given up for it
+        void* next = allocator.allocate(16);
+        UDO_ASSERT_EQ(static_cast<char*>(next), static_cast<char*>(small) + 16);
+        UDO_ASSERT_EQ(allocator.num_partially_used_slabs(), 0);
+
+        // over-aligned requests leave room to align in
+        void* aligned = allocator.allocate(100, 128);
+        UDO_ASSERT_EQ(reinterpret_cast<std::uintptr_t>(aligned) % 128, 0);
+        UDO_ASSERT_EQ(allocator.num_large_slabs(), 2);
+    });
+
+    context_suite->add_test("identifiers_interned_into_arena", [] {
+        using namespace udo::ast;
+        ASTContext context;
+        IdentifierTable& table = context.get_identifier_table();
+
+        std::string spelling = "counter";
+        const IdentifierInfo* a = table.get(spelling);
+        spelling[0] = 'C';
+        const IdentifierInfo* b = table.get("counter");
+
+        UDO_ASSERT_EQ(a, b);
+        UDO_ASSERT_STREQ(a->get_name(), "counter");
+        UDO_ASSERT_NE(table.get("Counter"), a);
+        UDO_ASSERT_EQ(table.size(), 2u);
+    });
+
+    context_suite->add_test("concurrent_interning", [] {
+        using namespace udo::ast;
+        ASTContext context;
+        IdentifierTable& table = context.get_identifier_table();
+
+        // every thread interns the same 500 names in a different order
+        std::vector<std::vector<const IdentifierInfo*>> seen(4, std::vector<const IdentifierInfo*>(500));
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&table, &seen, t] {
+                for (int i = 0; i < 500; ++i) {
+                    const int n = (i * 7 + t * 131) % 500;
+                    seen[t][n] = table.get("name_" + std::to_string(n));
+                }
+            });
+        }
+        for (std::thread& thread : threads) thread.join();
+
+        UDO_ASSERT_EQ(table.size(), 500u);
+        for (int n = 0; n < 500; ++n) {
+            for (int t = 1; t < 4; ++t) UDO_ASSERT_EQ(seen[t][n], seen[0][n]);
+            UDO_ASSERT_STREQ(seen[0][n]->get_name(), "name_" + std::to_string(n));
+        }
+    });
+
+    context_suite->add_test("interning_alongside_node_allocation", [] {
+        using namespace udo::ast;
+        ASTContext context(256);
+        IdentifierTable& table = context.get_identifier_table();
+
+        // a lexer thread interning while the parser allocates nodes, neither locks the node arena
+        std::thread lexer([&table] {
+            for (int i = 0; i < 2000; ++i) table.get("name_" + std::to_string(i));
+        });
+        std::vector<std::uint64_t*> nodes;
+        for (int i = 0; i < 2000; ++i) {
+            auto* node = static_cast<std::uint64_t*>(context.allocate(sizeof(std::uint64_t) * 4));
+            *node = static_cast<std::uint64_t>(i);
+            nodes.push_back(node);
+        }
+        lexer.join();
+
+        UDO_ASSERT_EQ(table.size(), 2000u);
+        UDO_ASSERT_STREQ(table.find("name_1999")->get_name(), "name_1999");
+        for (int i = 0; i < 2000; ++i) UDO_ASSERT_EQ(*nodes[i], static_cast<std::uint64_t>(i));
+    });
+
+    context_suite->add_test("named_decl_carries_identifier", [] {
+        using namespace udo::ast;
+        struct TestNamedDecl : NamedDecl {
+            explicit TestNamedDecl(const IdentifierInfo* name) : NamedDecl(Kind::Variable, name) {}
+        };
+
+        ASTContext context;
+        const IdentifierInfo* x = context.get_identifier_table().get("x");
+        const TestNamedDecl* decl = context.create<TestNamedDecl>(x);
+        UDO_ASSERT_EQ(decl->get_identifier(), x);
+        UDO_ASSERT_STREQ(decl->get_name(), "x");
+    });
+
     runner.add_suite(std::move(context_suite));
 
     // ========================================================================
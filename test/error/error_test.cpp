@@ -42,8 +42,8 @@ void register_error_tests(TestRunner& runner) {
     auto creation_suite = std::make_unique<TestSuite>("Error::Creation");
 
     creation_suite->add_test("CharSourceRange", []() {
-        Source_Location start(1, 10);
-        Source_Location end(1, 20);
+        Source_Location start(10);
+        Source_Location end(20);
         
         diag::CharSourceRange range = diag::CharSourceRange::getCharRange(start, end);
         UDO_ASSERT_TRUE(range.isValid());
@@ -58,13 +58,13 @@ void register_error_tests(TestRunner& runner) {
     });
 
     creation_suite->add_test("FixItHint", []() {
-        Source_Location loc(1, 5);
+        Source_Location loc(5);
         diag::FixItHint insert = diag::FixItHint::CreateInsertion(loc, "foo");
         UDO_ASSERT_FALSE(insert.isNull());
         UDO_ASSERT_STREQ(insert.code_to_insert, "foo");
         UDO_ASSERT_EQ(insert.remove_range.begin.offset, 5);
 
-        diag::CharSourceRange range = diag::CharSourceRange::getCharRange(Source_Location(1, 5), Source_Location(1, 10));
+        diag::CharSourceRange range = diag::CharSourceRange::getCharRange(Source_Location(5), Source_Location(10));
         diag::FixItHint remove = diag::FixItHint::CreateRemoval(range);
         UDO_ASSERT_STREQ(remove.code_to_insert, "");
         UDO_ASSERT_TRUE(remove.remove_range.isValid());
@@ -176,7 +176,7 @@ void register_error_tests(TestRunner& runner) {
         d.id = diag::common::err_unknown_identifier;
         d.message = "use of undeclared identifier 'y'";
         d.severity = diag::Severity::Error;
-        d.location = Source_Location(fid, 8); 
+        d.location = sm.get_location(fid, 8); 
         
         printer.HandleDiagnostic(diag::Severity::Error, d);
         
@@ -198,8 +198,8 @@ void register_error_tests(TestRunner& runner) {
         d.id = diag::common::err_unknown_identifier;
         d.message = "unknown identifiers 'y' and 'z'";
         d.severity = diag::Severity::Error;
-        d.location = Source_Location(fid, 8); // 'y'
-        d.extra_locations.push_back(Source_Location(fid, 12)); // 'z'
+        d.location = sm.get_location(fid, 8); // 'y'
+        d.extra_locations.push_back(sm.get_location(fid, 12)); // 'z'
         
         printer.HandleDiagnostic(diag::Severity::Error, d);
         
@@ -220,10 +220,10 @@ void register_error_tests(TestRunner& runner) {
         d.id = diag::common::err_unknown_identifier;
         d.message = "highlighted expression";
         d.severity = diag::Severity::Error;
-        d.location = Source_Location(fid, 10); // '+'
+        d.location = sm.get_location(fid, 10); // '+'
         // Highlight 'y' and 'z'
-        d.ranges.push_back(diag::CharSourceRange::getCharRange(Source_Location(fid, 8), Source_Location(fid, 9)));
-        d.ranges.push_back(diag::CharSourceRange::getCharRange(Source_Location(fid, 12), Source_Location(fid, 13)));
+        d.ranges.push_back(diag::CharSourceRange::getCharRange(sm.get_location(fid, 8), sm.get_location(fid, 9)));
+        d.ranges.push_back(diag::CharSourceRange::getCharRange(sm.get_location(fid, 12), sm.get_location(fid, 13)));
         
         printer.HandleDiagnostic(diag::Severity::Error, d);
         
@@ -243,8 +243,8 @@ void register_error_tests(TestRunner& runner) {
         d.id = diag::parse::err_expected_semicolon;
         d.message = "expected ';'";
         d.severity = diag::Severity::Error;
-        d.location = Source_Location(fid, 9);
-        d.fixits.push_back(diag::FixItHint::CreateInsertion(Source_Location(fid, 9), ";"));
+        d.location = sm.get_location(fid, 9);
+        d.fixits.push_back(diag::FixItHint::CreateInsertion(sm.get_location(fid, 9), ";"));
         
         printer.HandleDiagnostic(diag::Severity::Error, d);
         
@@ -275,7 +275,7 @@ void register_error_tests(TestRunner& runner) {
         // Check for caret color too
         capture.get_stream().str("");
         FileID fid = sm.add_buffer("foo", "test.udo");
-        d.location = Source_Location(fid, 0);
+        d.location = sm.get_location(fid, 0);
         printer.HandleDiagnostic(diag::Severity::Error, d);
         // Green color for caret
         UDO_ASSERT_CONTAINS(capture.get_output(), "\033[1;32m");
@@ -297,7 +297,7 @@ void register_error_tests(TestRunner& runner) {
         d.severity = diag::Severity::Error;
         // Offset for "line 2"
         // line 1\n = 7 chars
-        d.location = Source_Location(fid, 7); 
+        d.location = sm.get_location(fid, 7); 
         
         printer.HandleDiagnostic(diag::Severity::Error, d);
         
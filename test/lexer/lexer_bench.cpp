@@ -0,0 +1,369 @@
+//
+// Lexer Throughput Benchmark
+// Created by David Yang on 2026-03-15.
+//
+// Generates synthetic .udo corpora and times Lexer::tokenize over them, reporting throughput,
+// allocations per token and peak RSS as JSON lines or CSV so runs can be compared across releases.
+//
+// Usage: lexer_bench [--corpus=all|identifiers|numbers|operators|nested] [--sizes=1,16,64]
+//                    [--isa=active|all|scalar|sse2|avx2] [--repeat=3] [--threads=0] [--format=json|csv]
+//
+
+#include <lexer/lexer.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/resource.h>
+
+// ============================================================================
+// Allocation counting
+// ============================================================================
+
+namespace {
+    // tokenize() may lex on worker threads, so the counter is shared
+    std::atomic<std::size_t> allocation_count{0};
+}
+
+void* operator new(const std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(const std::size_t size, const std::align_val_t align) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    const auto alignment = static_cast<std::size_t>(align);
+    // aligned_alloc wants the size to be a multiple of the alignment
+    if (void* p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](const std::size_t size) { return operator new(size); }
+void* operator new[](const std::size_t size, const std::align_val_t align) { return operator new(size, align); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+namespace udo::bench {
+
+using namespace udo::lexer;
+
+// ============================================================================
+// Corpus generation
+// ============================================================================
+
+enum class Corpus { identifiers, numbers, operators, nested };
+
+constexpr Corpus all_corpora[] = {Corpus::identifiers, Corpus::numbers, Corpus::operators, Corpus::nested};
+
+constexpr std::string_view corpus_name(const Corpus corpus) {
+    switch (corpus) {
+        case Corpus::identifiers: return "identifiers";
+        case Corpus::numbers:     return "numbers";
+        case Corpus::operators:   return "operators";
+        case Corpus::nested:      return "nested";
+    }
+    return "";
+}
+
+/// Builds a corpus line by line from a fixed seed, so the same size always yields the same text.
+class Corpus_Generator {
+public:
+    explicit Corpus_Generator(const Corpus corpus) : corpus(corpus) {}
+
+    std::string generate(const std::size_t size) {
+        std::string out;
+        out.reserve(size + 256);
+        while (out.size() < size) {
+            switch (corpus) {
+                case Corpus::identifiers: identifier_line(out); break;
+                case Corpus::numbers:     number_line(out); break;
+                case Corpus::operators:   operator_line(out); break;
+                case Corpus::nested:      nested_function(out); break;
+            }
+        }
+        return out;
+    }
+
+private:
+    std::size_t pick(const std::size_t n) { return std::uniform_int_distribution<std::size_t>(0, n - 1)(rng); }
+
+    void identifier(std::string& out) {
+        static constexpr std::string_view syllables[] = {
+            "ka", "lo", "mi", "zu", "ter", "von", "ex", "qua", "rin", "do", "sel", "pha",
+        };
+        const std::size_t parts = 1 + pick(4);
+        for (std::size_t i = 0; i < parts; ++i) {
+            if (i != 0 && pick(3) == 0) out += '_';
+            out += syllables[pick(std::size(syllables))];
+        }
+        if (pick(4) == 0) out += std::to_string(pick(100));
+    }
+
+    void number(std::string& out) {
+        switch (pick(6)) {
+            case 0: out += std::to_string(pick(1'000'000)); break;
+            case 1: out += "0x" + to_hex(pick(1u << 31)); break;
+            case 2: out += "0b1011_0110"; break;
+            case 3: out += std::to_string(pick(100'000)) + "." + std::to_string(pick(1000)); break;
+            case 4: out += std::to_string(pick(1000)) + ".5e" + std::to_string(pick(300)); break;
+            default: out += std::to_string(pick(1'000'000'000)) + (pick(2) ? "ull" : "u"); break;
+        }
+    }
+
+    static std::string to_hex(std::size_t value) {
+        static constexpr char digits[] = "0123456789ABCDEF";
+        std::string hex;
+        do hex.insert(hex.begin(), digits[value & 0xF]); while (value >>= 4);
+        return hex;
+    }
+
+    // let foo_bar = baz + qux.quux;
+    void identifier_line(std::string& out) {
+        out += "let ";
+        identifier(out);
+        out += " = ";
+        const std::size_t terms = 2 + pick(4);
+        for (std::size_t i = 0; i < terms; ++i) {
+            if (i != 0) out += pick(2) ? " + " : ".";
+            identifier(out);
+        }
+        out += ";\n";
+    }
+
+    // let n = 123 * 0x1F + 4.5e10;
+    void number_line(std::string& out) {
+        out += "let n = ";
+        const std::size_t terms = 4 + pick(6);
+        for (std::size_t i = 0; i < terms; ++i) {
+            if (i != 0) out += pick(2) ? " + " : " * ";
+            number(out);
+        }
+        out += ";\n";
+    }
+
+    // a += b << c && !d == e->f :: g ... h;
+    void operator_line(std::string& out) {
+        static constexpr std::string_view operators[] = {
+            "+", "-", "*", "/", "=", "==", "!=", "<=", ">=", "<", ">", "<<", ">>", "&&", "||",
+            "+=", "-=", "->", "=>", "::", "..", "...", "!", "&", "|", "^", "~", "%", ".",
+        };
+        out += 'a';
+        const std::size_t terms = 8 + pick(8);
+        for (std::size_t i = 0; i < terms; ++i) {
+            out += operators[pick(std::size(operators))];
+            out += static_cast<char>('a' + pick(26));
+        }
+        out += ";\n";
+    }
+
+    // a function body with blocks and parenthesized expressions nested `depth` levels deep
+    void nested_function(std::string& out) {
+        const std::size_t depth = 16 + pick(48);
+        out += "f";
+        out += std::to_string(pick(10'000));
+        out += "() :: i32 {\n";
+        for (std::size_t level = 0; level < depth; ++level) {
+            out.append(level + 1, ' ');
+            out += "if (x) {\n";
+        }
+        out.append(depth + 1, ' ');
+        out += "return ";
+        out.append(depth, '(');
+        out += 'x';
+        for (std::size_t level = 0; level < depth; ++level) out += level % 2 ? " + 1)" : "[i])";
+        out += ";\n";
+        for (std::size_t level = depth; level > 0; --level) {
+            out.append(level, ' ');
+            out += "}\n";
+        }
+        out += "}\n";
+    }
+
+    Corpus corpus;
+    std::mt19937_64 rng{0x5544'4F00};
+};
+
+// ============================================================================
+// Measurement
+// ============================================================================
+
+struct Bench_Options {
+    std::vector<Corpus> corpora{std::begin(all_corpora), std::end(all_corpora)};
+    std::vector<std::size_t> sizes_mb{1, 16, 64};
+    std::vector<const Char_Scanners*> scanners{&active_scanners()};   // scanners to run each corpus with
+    unsigned repeat = 3;
+    unsigned threads = 0;       // Parallel_Options::max_threads, 0 is every hardware thread
+    bool csv = false;
+};
+
+struct Bench_Result {
+    Corpus corpus;
+    const char* isa;
+    std::size_t bytes;
+    std::size_t tokens;
+    double best_seconds;        // fastest of the repeats, the least disturbed by the rest of the machine
+    double median_seconds;
+    std::size_t allocations;    // during a single tokenize()
+    long peak_rss_kb;           // high-water mark of the whole process so far
+};
+
+long peak_rss_kb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;  // bytes on macOS, kilobytes everywhere else
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+Bench_Result run(const Corpus corpus, const std::size_t size_mb, const Char_Scanners& scanners,
+                 const Bench_Options& options) {
+    Buffer buffer;
+    buffer.data = Corpus_Generator(corpus).generate(size_mb << 20);
+
+    Lexer lexer(buffer);
+    lexer.set_scanners(scanners);
+    Parallel_Options parallel = lexer.get_parallel_options();
+    parallel.max_threads = options.threads;
+    lexer.set_parallel_options(parallel);
+
+    Bench_Result result{corpus, scanners.name, buffer.data.size(), 0, 0, 0, 0, 0};
+    std::vector<double> seconds;
+    for (unsigned i = 0; i < std::max(options.repeat, 1u); ++i) {
+        const std::size_t allocations_before = allocation_count.load(std::memory_order_relaxed);
+        const auto start = std::chrono::steady_clock::now();
+        const TokenStream tokens = lexer.tokenize();
+        const auto stop = std::chrono::steady_clock::now();
+
+        result.allocations = allocation_count.load(std::memory_order_relaxed) - allocations_before;
+        result.tokens = tokens.size();
+        seconds.push_back(std::chrono::duration<double>(stop - start).count());
+    }
+
+    std::ranges::sort(seconds);
+    result.best_seconds = seconds.front();
+    result.median_seconds = seconds[seconds.size() / 2];
+    result.peak_rss_kb = peak_rss_kb();
+    return result;
+}
+
+void report(const Bench_Result& result, const bool csv) {
+    const double mb = static_cast<double>(result.bytes) / (1 << 20);
+    const double mb_per_s = mb / result.best_seconds;
+    const double tokens_per_s = static_cast<double>(result.tokens) / result.best_seconds;
+    const double allocations_per_token = result.tokens ? static_cast<double>(result.allocations) / result.tokens : 0;
+
+    if (csv) {
+        std::printf("%s,%s,%zu,%zu,%.6f,%.6f,%.2f,%.0f,%.6f,%ld\n", corpus_name(result.corpus).data(), result.isa,
+                    result.bytes, result.tokens, result.best_seconds, result.median_seconds, mb_per_s, tokens_per_s,
+                    allocations_per_token, result.peak_rss_kb);
+    } else {
+        std::printf("{\"bench\":\"lexer.tokenize\",\"corpus\":\"%s\",\"isa\":\"%s\",\"bytes\":%zu,\"tokens\":%zu,"
+                    "\"best_s\":%.6f,\"median_s\":%.6f,\"mb_per_s\":%.2f,\"tokens_per_s\":%.0f,"
+                    "\"allocs_per_token\":%.6f,\"peak_rss_kb\":%ld}\n",
+                    corpus_name(result.corpus).data(), result.isa, result.bytes, result.tokens, result.best_seconds,
+                    result.median_seconds, mb_per_s, tokens_per_s, allocations_per_token, result.peak_rss_kb);
+    }
+    std::fflush(stdout);
+}
+
+bool parse_options(const int argc, char* argv[], Bench_Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg.starts_with("--corpus=")) {
+            const std::string_view name = arg.substr(9);
+            if (name == "all") continue;
+            const auto it = std::ranges::find(all_corpora, name, corpus_name);
+            if (it == std::end(all_corpora)) {
+                std::cerr << "unknown corpus '" << name << "'\n";
+                return false;
+            }
+            options.corpora = {*it};
+        } else if (arg.starts_with("--sizes=")) {
+            options.sizes_mb.clear();
+            std::string_view list = arg.substr(8);
+            while (!list.empty()) {
+                const std::size_t comma = std::min(list.find(','), list.size());
+                const std::size_t mb = std::strtoull(std::string(list.substr(0, comma)).c_str(), nullptr, 10);
+                if (mb < 1 || mb > 500) {
+                    std::cerr << "sizes are in MB and must be between 1 and 500\n";
+                    return false;
+                }
+                options.sizes_mb.push_back(mb);
+                list.remove_prefix(std::min(comma + 1, list.size()));
+            }
+            // the peak RSS column is a process-wide high-water mark, so it only means something in ascending order
+            std::ranges::sort(options.sizes_mb);
+        } else if (arg.starts_with("--isa=")) {
+            // pinning the scanners shows a dispatch regression in the numbers, not just in correctness tests
+            const std::string_view name = arg.substr(6);
+            if (name == "active") {
+                options.scanners = {&active_scanners()};
+                continue;
+            }
+            options.scanners.clear();
+            for (const Scan_ISA isa : {Scan_ISA::scalar, Scan_ISA::sse2, Scan_ISA::avx2}) {
+                const Char_Scanners* scanners = get_scanners(isa);
+                if (scanners && (name == "all" || name == scanners->name)) options.scanners.push_back(scanners);
+            }
+            if (options.scanners.empty()) {
+                std::cerr << "isa '" << name << "' is unknown or not supported by this build or CPU\n";
+                return false;
+            }
+        } else if (arg.starts_with("--repeat=")) {
+            options.repeat = static_cast<unsigned>(std::strtoul(argv[i] + 9, nullptr, 10));
+        } else if (arg.starts_with("--threads=")) {
+            options.threads = static_cast<unsigned>(std::strtoul(argv[i] + 10, nullptr, 10));
+        } else if (arg == "--format=csv") {
+            options.csv = true;
+        } else if (arg == "--format=json") {
+            options.csv = false;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--corpus=all|identifiers|numbers|operators|nested]"
+                      << " [--sizes=1,16,64] [--isa=active|all|scalar|sse2|avx2] [--repeat=3] [--threads=0]"
+                      << " [--format=json|csv]\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace udo::bench
+
+int main(const int argc, char* argv[]) {
+    using namespace udo::bench;
+
+    Bench_Options options;
+    if (!parse_options(argc, argv, options)) return 1;
+
+    if (options.csv) {
+        std::printf("corpus,isa,bytes,tokens,best_s,median_s,mb_per_s,tokens_per_s,allocs_per_token,peak_rss_kb\n");
+    }
+    for (const std::size_t size_mb : options.sizes_mb) {
+        for (const Corpus corpus : options.corpora) {
+            for (const Char_Scanners* scanners : options.scanners) {
+                report(run(corpus, size_mb, *scanners, options), options.csv);
+            }
+        }
+    }
+    return 0;
+}
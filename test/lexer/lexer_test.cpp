@@ -5,22 +5,41 @@
 
 #include "lexer_test.hpp"
 #include <lexer/lexer.hpp>
+#include <lexer/char_scan.hpp>
+#include <lexer/token_channel.hpp>
+#include <support/utf8.hpp>
+#include <support/source_prefetcher.hpp>
+#include <error/error.hpp>
+#include <filesystem>
+#include <fstream>
 #include <sstream>
+#include <deque>
+#include <memory>
+#include <thread>
 
 namespace udo::test {
 
 using namespace udo::lexer;
 
-// Helper function to tokenize a string
-static std::vector<Token> tokenize_string(const std::string& input) {
-    std::istringstream stream(input);
-    Lexer lexer(stream);
-    auto [tokens, unfiltered, lines] = lexer.tokenize();
+// Helper function to tokenize a string. Lexemes view into the lexed buffer,
+// so every buffer is kept alive for the remainder of the test run.
+static TokenStream tokenize_string(const std::string& input) {
+    static std::deque<Buffer> buffers;
+    Buffer& buffer = buffers.emplace_back();
+    buffer.data = input;
+    Lexer lexer(buffer);
+    auto tokens = lexer.tokenize();
     return tokens;
 }
 
+// String_Storage for tests, decoded literals are kept alive for the remainder of the test run
+static const char* store_test_string(void*, const std::string_view decoded) {
+    static std::deque<std::string> strings;
+    return strings.emplace_back(decoded).data();
+}
+
 // Helper to get token without newlines and EOF
-static std::vector<Token> get_meaningful_tokens(const std::vector<Token>& tokens) {
+static std::vector<Token> get_meaningful_tokens(const TokenStream& tokens) {
     std::vector<Token> result;
     for (const auto& tok : tokens) {
         if (tok.type != TokenType::newline && tok.type != TokenType::eof) {
@@ -185,6 +204,23 @@ void register_lexer_tests(TestRunner& runner) {
         UDO_ASSERT_EQ(static_cast<int>(tokens[0].type), static_cast<int>(TokenType::kw_as));
     });
 
+    keyword_suite->add_test("every_keyword_round_trips", []() {
+        for (const auto& [spelling, type] : keyword_spellings) {
+            auto tokens = get_meaningful_tokens(tokenize_string(std::string(spelling)));
+            UDO_ASSERT_EQ(tokens.size(), 1u);
+            UDO_ASSERT_EQ(static_cast<int>(tokens[0].type), static_cast<int>(type));
+            UDO_ASSERT_TRUE(is_keyword_type(tokens[0].type));
+        }
+    });
+
+    keyword_suite->add_test("keyword_prefixes_and_extensions_are_identifiers", []() {
+        auto tokens = get_meaningful_tokens(tokenize_string("i1 i1280 le lets functors f12 bindx"));
+        UDO_ASSERT_EQ(tokens.size(), 7u);
+        for (const auto& t : tokens) {
+            UDO_ASSERT_EQ(static_cast<int>(t.type), static_cast<int>(TokenType::identifier));
+        }
+    });
+
     runner.add_suite(std::move(keyword_suite));
 
     // ========================================================================
@@ -372,6 +408,24 @@ void register_lexer_tests(TestRunner& runner) {
         UDO_ASSERT_EQ(static_cast<int>(tokens[0].type), static_cast<int>(TokenType::bang));
     });
 
+    symbol_suite->add_test("multi_char_operators_longest_match", []() {
+        auto tokens = get_meaningful_tokens(tokenize_string("a<<@b ^+ -> <<"));
+        UDO_ASSERT_EQ(tokens.size(), 6u);
+        UDO_ASSERT_STREQ(tokens[1].lexeme, "<<@");
+        UDO_ASSERT_STREQ(tokens[3].lexeme, "^+");
+        UDO_ASSERT_STREQ(tokens[4].lexeme, "->");
+        UDO_ASSERT_STREQ(tokens[5].lexeme, "<<");
+    });
+
+    symbol_suite->add_test("symbol_type_lookup", []() {
+        UDO_ASSERT_EQ(static_cast<int>(get_symbol_type("::")), static_cast<int>(TokenType::double_colon));
+        UDO_ASSERT_EQ(static_cast<int>(get_symbol_type("...")), static_cast<int>(TokenType::triple_dot));
+        UDO_ASSERT_EQ(static_cast<int>(get_symbol_type("\\")), static_cast<int>(TokenType::unknown));
+        UDO_ASSERT_EQ(static_cast<int>(get_symbol_type("=>")), static_cast<int>(TokenType::unknown));
+        UDO_ASSERT_EQ(static_cast<int>(get_symbol_type("=!")), static_cast<int>(TokenType::unknown));
+        UDO_ASSERT_EQ(static_cast<int>(get_symbol_type("")), static_cast<int>(TokenType::unknown));
+    });
+
     runner.add_suite(std::move(symbol_suite));
 
     // ========================================================================
@@ -428,33 +482,238 @@ void register_lexer_tests(TestRunner& runner) {
     auto position_suite = std::make_unique<TestSuite>("Lexer::Positions");
 
     position_suite->add_test("first_token_column", []() {
-        auto tokens = get_meaningful_tokens(tokenize_string("foo"));
-        UDO_ASSERT_EQ(tokens.size(), 1u);
-        UDO_ASSERT_EQ(tokens[0].column, 1);
+        auto tokens = tokenize_string("foo");
+        UDO_ASSERT_EQ(get_meaningful_tokens(tokens).size(), 1u);
+        UDO_ASSERT_EQ(tokens.line_column(0).second, 1u);
     });
 
     position_suite->add_test("second_token_column", []() {
-        auto tokens = get_meaningful_tokens(tokenize_string("foo bar"));
-        UDO_ASSERT_EQ(tokens.size(), 2u);
-        UDO_ASSERT_EQ(tokens[0].column, 1);
-        UDO_ASSERT_EQ(tokens[1].column, 5);
+        auto tokens = tokenize_string("foo bar");
+        UDO_ASSERT_EQ(get_meaningful_tokens(tokens).size(), 2u);
+        UDO_ASSERT_EQ(tokens.line_column(0).second, 1u);
+        UDO_ASSERT_EQ(tokens.line_column(1).second, 5u);
     });
 
     position_suite->add_test("multiline_line_numbers", []() {
         auto tokens = tokenize_string("foo\nbar\nbaz");
-        int foo_line = -1, bar_line = -1, baz_line = -1;
-        for (const auto& t : tokens) {
-            if (t.lexeme == "foo") foo_line = t.line;
-            if (t.lexeme == "bar") bar_line = t.line;
-            if (t.lexeme == "baz") baz_line = t.line;
+        std::size_t foo_line = 0, bar_line = 0, baz_line = 0;
+        for (std::size_t i = 0; i < tokens.size(); ++i) {
+            if (tokens.lexeme(i) == "foo") foo_line = tokens.line_column(i).first;
+            if (tokens.lexeme(i) == "bar") bar_line = tokens.line_column(i).first;
+            if (tokens.lexeme(i) == "baz") baz_line = tokens.line_column(i).first;
         }
-        UDO_ASSERT_EQ(foo_line, 1);
-        UDO_ASSERT_EQ(bar_line, 2);
-        UDO_ASSERT_EQ(baz_line, 3);
+        UDO_ASSERT_EQ(foo_line, 1u);
+        UDO_ASSERT_EQ(bar_line, 2u);
+        UDO_ASSERT_EQ(baz_line, 3u);
+    });
+
+    position_suite->add_test("locations_are_global_offsets", []() {
+        Source_Manager sources;
+        const FileID first = sources.add_buffer("a b c");
+        const FileID second = sources.add_buffer("let\n  x", "second.udo");
+        Lexer lexer(*sources.getBuffer(second), second);
+        auto tokens = lexer.tokenize();
+        UDO_ASSERT_STREQ(tokens.lexeme(2), "x");
+        UDO_ASSERT_TRUE(tokens.location(2) == sources.get_location(second, 6));
+        UDO_ASSERT_EQ(sources.get_file_id(tokens.location(2)), second);
+        UDO_ASSERT_EQ(sources.get_file_offset(tokens.location(2)), 6u);
+        UDO_ASSERT_EQ(tokens.line_column(2, sources).first, 2u);
+        UDO_ASSERT_EQ(tokens.line_column(2, sources).second, 3u);
+        UDO_ASSERT_STREQ(sources.getFilePath(tokens.location(2)), "second.udo");
+
+        // every slice has room for its eof location, which does not run into the next file
+        UDO_ASSERT_EQ(sources.get_file_id(sources.get_location(first, 5)), first);
+        UDO_ASSERT_EQ(sources.get_file_id(sources.get_location(second, 0)), second);
+        UDO_ASSERT_EQ(sources.get_file_id(sources.get_location(first, 0)), first);
+        UDO_ASSERT_EQ(sources.get_file_id(Source_Location{}), 0u);
+        UDO_ASSERT_EQ(sizeof(Source_Location), 4u);
     });
 
     runner.add_suite(std::move(position_suite));
 
+    // ========================================================================
+    // Unicode Tests
+    // ========================================================================
+
+    auto unicode_suite = std::make_unique<TestSuite>("Lexer::Unicode");
+
+    unicode_suite->add_test("utf8_identifiers", []() {
+        auto tokens = get_meaningful_tokens(tokenize_string("let \xC3\xA9t\xC3\xA9 = \xE5\x90\x8D\xE5\x89\x8D_2 + x\xF0\x9F\x98\x80;"));
+        UDO_ASSERT_EQ(tokens.size(), 7u);
+        UDO_ASSERT_EQ(static_cast<int>(tokens[1].type), static_cast<int>(TokenType::identifier));
+        UDO_ASSERT_STREQ(tokens[1].lexeme, "\xC3\xA9t\xC3\xA9");
+        UDO_ASSERT_STREQ(tokens[3].lexeme, "\xE5\x90\x8D\xE5\x89\x8D_2");
+        UDO_ASSERT_STREQ(tokens[5].lexeme, "x\xF0\x9F\x98\x80");
+    });
+
+    unicode_suite->add_test("unicode_space_and_invalid_bytes_are_unknown", []() {
+        // a no-break space is one unknown token of both its bytes, a stray continuation byte is one of its own
+        auto tokens = get_meaningful_tokens(tokenize_string("a\xC2\xA0" "b \x80"));
+        UDO_ASSERT_EQ(tokens.size(), 4u);
+        UDO_ASSERT_EQ(static_cast<int>(tokens[1].type), static_cast<int>(TokenType::unknown));
+        UDO_ASSERT_EQ(tokens[1].lexeme.size(), 2u);
+        UDO_ASSERT_STREQ(tokens[2].lexeme, "b");
+        UDO_ASSERT_EQ(static_cast<int>(tokens[3].type), static_cast<int>(TokenType::unknown));
+        UDO_ASSERT_EQ(tokens[3].lexeme.size(), 1u);
+    });
+
+    unicode_suite->add_test("columns_count_code_points", []() {
+        auto tokens = tokenize_string("x\n\xC3\xA9\xE5\x90\x8D = y");
+        UDO_ASSERT_STREQ(tokens.lexeme(4), "y");
+        UDO_ASSERT_EQ(tokens.line_column(4).first, 2u);
+        UDO_ASSERT_EQ(tokens.line_column(4).second, 6u);
+        UDO_ASSERT_EQ(tokens.line_column(0).second, 1u);
+    });
+
+    unicode_suite->add_test("validate_finds_first_ill_formed_sequence", []() {
+        const auto check = [](const std::string& in) { return utf8::validate(in.data(), in.size()); };
+        const std::string ascii(40, 'a');
+        UDO_ASSERT_TRUE(check(ascii).ascii);
+        UDO_ASSERT_EQ(check(ascii).first_invalid, 40u);
+        UDO_ASSERT_FALSE(check(ascii + "\xC3\xA9").ascii);
+        UDO_ASSERT_EQ(check(ascii + "\xC3\xA9").first_invalid, 42u);
+        UDO_ASSERT_EQ(check(ascii + "\xC0\xAF").first_invalid, 40u);          // overlong '/'
+        UDO_ASSERT_EQ(check(ascii + "\xED\xA0\x80").first_invalid, 40u);     // surrogate
+        UDO_ASSERT_EQ(check(ascii + "\xF4\x90\x80\x80").first_invalid, 40u); // past U+10FFFF
+        UDO_ASSERT_EQ(check("\xE5\x90\x8D" + ascii + "\xE5\x90").first_invalid, 43u); // truncated
+    });
+
+    unicode_suite->add_test("count_code_points_matches_decoding", []() {
+        std::string in;
+        for (int i = 0; i < 20; ++i) in += "a\xC3\xA9\xE5\x90\x8D\xF0\x9F\x98\x80";
+        UDO_ASSERT_EQ(utf8::count_code_points(in.data(), in.size()), 80u);
+        UDO_ASSERT_EQ(utf8::count_code_points(in.data(), 3), 2u);
+    });
+
+    runner.add_suite(std::move(unicode_suite));
+
+    // ========================================================================
+    // String, Char and Comment Tests
+    // ========================================================================
+
+    auto quoted_suite = std::make_unique<TestSuite>("Lexer::StringsAndComments");
+
+    quoted_suite->add_test("plain_string_is_a_view_of_the_source", []() {
+        Buffer buffer;
+        buffer.data = "let s = \"hello world\";";
+        Lexer lexer(buffer);
+        lexer.set_string_storage({nullptr, store_test_string});
+        auto tokens = lexer.tokenize();
+        UDO_ASSERT_EQ(static_cast<int>(tokens.kind(3)), static_cast<int>(TokenType::string_literal));
+        UDO_ASSERT_STREQ(tokens.lexeme(3), "\"hello world\"");
+        UDO_ASSERT_EQ(string_contents(tokens.lexeme(3)).data(), buffer.data.data() + 9);
+        UDO_ASSERT_NULL(tokens.decoded_string(3));
+        UDO_ASSERT_EQ(static_cast<int>(tokens.kind(4)), static_cast<int>(TokenType::semicolon));
+    });
+
+    quoted_suite->add_test("escapes_are_decoded_once_into_storage", []() {
+        Buffer buffer;
+        buffer.data = "\"a\\tb\\\"c\\\\ \\x41\\u{e9}\" 'x' '\\n'";
+        Lexer lexer(buffer);
+        lexer.set_string_storage({nullptr, store_test_string});
+        auto tokens = lexer.tokenize();
+        UDO_ASSERT_EQ(static_cast<int>(tokens.kind(0)), static_cast<int>(TokenType::string_literal));
+        UDO_ASSERT_STREQ(tokens.lexeme(0), buffer.data.substr(0, buffer.data.find(" '")));
+        UDO_ASSERT_NOT_NULL(tokens.decoded_string(0));
+        UDO_ASSERT_STREQ(*tokens.decoded_string(0), "a\tb\"c\\ A\xC3\xA9");
+        UDO_ASSERT_EQ(static_cast<int>(tokens.kind(1)), static_cast<int>(TokenType::char_literal));
+        UDO_ASSERT_NULL(tokens.decoded_string(1));
+        UDO_ASSERT_STREQ(*tokens.decoded_string(2), "\n");
+        UDO_ASSERT_TRUE(lexer.get_pending_diagnostics().empty());
+    });
+
+    quoted_suite->add_test("escapes_without_storage_are_left_to_the_reader", []() {
+        auto tokens = tokenize_string("\"\\n\"");
+        UDO_ASSERT_EQ(static_cast<int>(tokens.kind(0)), static_cast<int>(TokenType::string_literal));
+        UDO_ASSERT_NULL(tokens.decoded_string(0));
+        std::string decoded;
+        UDO_ASSERT_EQ(decode_escapes(string_contents(tokens.lexeme(0)), decoded), std::string_view::npos);
+        UDO_ASSERT_STREQ(decoded, "\n");
+    });
+
+    quoted_suite->add_test("string_contents_strips_quotes", []() {
+        UDO_ASSERT_STREQ(string_contents("\"abc\""), "abc");
+        UDO_ASSERT_STREQ(string_contents("\"abc"), "abc");
+        UDO_ASSERT_STREQ(string_contents("\"ab\\\""), "ab\\\"");      // closing quote is escaped
+        UDO_ASSERT_STREQ(string_contents("\"ab\\\\\""), "ab\\\\");  // escaped backslash, then the quote
+        UDO_ASSERT_STREQ(string_contents("''"), "");
+    });
+
+    quoted_suite->add_test("unterminated_and_invalid_literals_are_diagnosed", []() {
+        Buffer buffer;
+        buffer.data = "\"abc\nx '' 'ab' \"\\q\" 'y";
+        Lexer lexer(buffer);
+        auto tokens = lexer.tokenize();
+        UDO_ASSERT_STREQ(tokens.lexeme(0), "\"abc");
+        UDO_ASSERT_EQ(static_cast<int>(tokens.kind(1)), static_cast<int>(TokenType::newline));
+        UDO_ASSERT_STREQ(tokens.lexeme(2), "x");
+        UDO_ASSERT_STREQ(tokens.lexeme(6), "'y");
+
+        const auto& diags = lexer.get_pending_diagnostics();
+        UDO_ASSERT_EQ(diags.size(), 5u);
+        UDO_ASSERT_EQ(diags[0].id, diag::lex::err_unterminated_string);
+        UDO_ASSERT_EQ(diags[0].location.offset, 0u);
+        UDO_ASSERT_EQ(diags[1].id, diag::lex::err_empty_character_literal);
+        UDO_ASSERT_EQ(diags[2].id, diag::lex::warn_multi_char_constant);
+        UDO_ASSERT_EQ(diags[3].id, diag::lex::err_invalid_escape_sequence);
+        UDO_ASSERT_EQ(diags[3].location.offset, 16u);
+        UDO_ASSERT_EQ(diags[4].id, diag::lex::err_unterminated_char);
+    });
+
+    quoted_suite->add_test("line_comment_runs_to_end_of_line", []() {
+        auto tokens = tokenize_string("let x = 2; // it's \"fine\" /* here\nlet");
+        UDO_ASSERT_EQ(static_cast<int>(tokens.kind(5)), static_cast<int>(TokenType::comment));
+        UDO_ASSERT_STREQ(tokens.lexeme(5), "// it's \"fine\" /* here");
+        UDO_ASSERT_EQ(static_cast<int>(tokens.kind(6)), static_cast<int>(TokenType::newline));
+        UDO_ASSERT_EQ(static_cast<int>(tokens.kind(7)), static_cast<int>(TokenType::kw_let));
+    });
+
+    quoted_suite->add_test("block_comment_spans_lines", []() {
+        auto tokens = tokenize_string("a /* x\n \"y\n*/ b / c\nd");
+        UDO_ASSERT_STREQ(tokens.lexeme(0), "a");
+        UDO_ASSERT_EQ(static_cast<int>(tokens.kind(1)), static_cast<int>(TokenType::comment));
+        UDO_ASSERT_STREQ(tokens.lexeme(1), "/* x\n \"y\n*/");
+        UDO_ASSERT_STREQ(tokens.lexeme(2), "b");
+        UDO_ASSERT_EQ(tokens.line_column(2).first, 3u);
+        UDO_ASSERT_EQ(static_cast<int>(tokens.kind(3)), static_cast<int>(TokenType::slash));
+        UDO_ASSERT_EQ(static_cast<int>(tokens.kind(5)), static_cast<int>(TokenType::newline));
+        UDO_ASSERT_STREQ(tokens.lexeme(6), "d");
+    });
+
+    quoted_suite->add_test("unterminated_block_comment_runs_to_eof", []() {
+        Buffer buffer;
+        buffer.data = "a /* b\nc\n";
+        Lexer lexer(buffer);
+        auto tokens = get_meaningful_tokens(lexer.tokenize());
+        UDO_ASSERT_EQ(tokens.size(), 2u);
+        UDO_ASSERT_STREQ(tokens[1].lexeme, "/* b\nc\n");
+        UDO_ASSERT_EQ(lexer.get_pending_diagnostics().size(), 1u);
+        UDO_ASSERT_EQ(lexer.get_pending_diagnostics()[0].id, diag::lex::err_unterminated_block_comment);
+    });
+
+    quoted_suite->add_test("streaming_and_channel_carry_decoded_strings", []() {
+        Buffer buffer;
+        buffer.data = "\"\\t\" \"plain\" 1";
+        Lexer lexer(buffer);
+        lexer.set_string_storage({nullptr, store_test_string});
+        UDO_ASSERT_NOT_NULL(lexer.decoded_string(lexer.peek()));
+        UDO_ASSERT_NULL(lexer.decoded_string(lexer.peek(1)));
+        const Token escaped = lexer.next_token();
+        UDO_ASSERT_STREQ(*lexer.decoded_string(escaped), "\t");
+
+        Lexer producer_lexer(buffer);
+        producer_lexer.set_string_storage({nullptr, store_test_string});
+        Token_Channel channel;
+        std::thread producer([&] { channel.produce_from(producer_lexer); });
+        const Token first = channel.next_token();
+        UDO_ASSERT_NOT_NULL(channel.decoded_string(first));
+        UDO_ASSERT_STREQ(*channel.decoded_string(first), "\t");
+        UDO_ASSERT_NULL(channel.decoded_string(channel.next_token()));
+        producer.join();
+    });
+
+    runner.add_suite(std::move(quoted_suite));
+
     // ========================================================================
     // Edge Case Tests
     // ========================================================================
@@ -496,6 +755,1062 @@ void register_lexer_tests(TestRunner& runner) {
     });
 
     runner.add_suite(std::move(edge_suite));
+
+    // ========================================================================
+    // Source Storage Tests
+    // ========================================================================
+
+    auto storage_suite = std::make_unique<TestSuite>("Lexer::SourceStorage");
+
+    storage_suite->add_test("lexemes_view_into_buffer", []() {
+        Buffer buffer;
+        buffer.data = "let value = 42;";
+        Lexer lexer(buffer, 1);
+        auto tokens = lexer.tokenize();
+        auto meaningful = get_meaningful_tokens(tokens);
+        UDO_ASSERT_EQ(meaningful.size(), 5u);
+        UDO_ASSERT_EQ(lexer.get_file_id(), 1u);
+        for (const auto& t : meaningful) {
+            UDO_ASSERT_TRUE(t.lexeme.data() >= buffer.data.data());
+            UDO_ASSERT_TRUE(t.lexeme.data() + t.lexeme.size() <= buffer.data.data() + buffer.data.size());
+        }
+        UDO_ASSERT_EQ(meaningful[1].lexeme.data(), buffer.data.data() + 4);
+    });
+
+    storage_suite->add_test("token_stream_is_compact", []() {
+        std::string input;
+        for (int i = 0; i < 1000; ++i) input += "let x = 42;\n";
+        auto tokens = tokenize_string(input);
+        UDO_ASSERT_EQ(tokens.size(), 6001u);
+        // kind + 32-bit offset + 32-bit length per token, against 48 bytes for an owning token
+        UDO_ASSERT_LE(tokens.memory_usage(), tokens.size() * 48 / 5);
+    });
+
+    storage_suite->add_test("stream_lexer_owns_source", []() {
+        std::istringstream stream("foo bar");
+        Lexer lexer(stream);
+        auto tokens = lexer.tokenize();
+        auto meaningful = get_meaningful_tokens(tokens);
+        UDO_ASSERT_EQ(meaningful.size(), 2u);
+        UDO_ASSERT_STREQ(meaningful[1].lexeme, "bar");
+        UDO_ASSERT_EQ(meaningful[1].lexeme.data(), lexer.get_source().data() + 4);
+    });
+
+    storage_suite->add_test("trivia_is_opt_in", []() {
+        Buffer buffer;
+        buffer.data = "foo   bar\n  baz";
+        Lexer lexer(buffer);
+        Trivia_Table trivia;
+        auto tokens = lexer.tokenize(trivia);
+        // foo, bar, newline, baz, newline, eof with whitespace before bar and baz only
+        UDO_ASSERT_EQ(tokens.size(), 6u);
+        UDO_ASSERT_EQ(trivia.size(), 2u);
+        UDO_ASSERT_EQ(trivia.token_index(0), 1u);
+        UDO_ASSERT_EQ(trivia.offset(0), 3u);
+        UDO_ASSERT_EQ(trivia.length(0), 3u);
+        UDO_ASSERT_EQ(trivia.token_index(1), 3u);
+        UDO_ASSERT_EQ(trivia.length(1), 2u);
+
+        auto [first, last] = trivia.leading(3);
+        UDO_ASSERT_EQ(last - first, 1u);
+        auto [none_first, none_last] = trivia.leading(2);
+        UDO_ASSERT_EQ(none_first, none_last);
+
+        UDO_ASSERT_STREQ(buffer.get_line_text(2), "  baz");
+    });
+
+    storage_suite->add_test("tokens_and_trivia_round_trip", []() {
+        Buffer buffer;
+        buffer.data = "  let x :\ti32 = 42 ;  \n\n\tfn\tf ( ) { }   \r\n@ # ";
+        Lexer lexer(buffer);
+        Trivia_Table trivia;
+        auto tokens = lexer.tokenize(trivia);
+
+        std::string rebuilt;
+        for (std::uint32_t i = 0; i < tokens.size(); ++i) {
+            auto [first, last] = trivia.leading(i);
+            for (std::size_t t = first; t < last; ++t) {
+                rebuilt += buffer.data.substr(trivia.offset(t), trivia.length(t));
+            }
+            rebuilt += tokens.lexeme(i);
+        }
+        UDO_ASSERT_STREQ(rebuilt, buffer.data);
+    });
+
+    storage_suite->add_test("line_table_is_lazy_and_exact", []() {
+        // newlines on both sides of the 16-byte blocks, in runs, and as the very last byte
+        std::string input = "\n";
+        for (int i = 0; i < 40; ++i) input += std::string(i % 19, 'x') + (i % 5 == 0 ? "\n\n" : "\n");
+        input += "tail\n";
+
+        Source_Manager sources;
+        Buffer& buffer = *sources.getBuffer(sources.add_buffer(input));
+        UDO_ASSERT_FALSE(buffer.computed);
+
+        std::vector<std::size_t> expected{0};
+        for (std::size_t i = 0; i < input.size(); ++i) {
+            if (input[i] == '\n') expected.push_back(i + 1);
+        }
+        const auto [line, column] = buffer.get_line_column(input.find("tail") + 2);
+        UDO_ASSERT_TRUE(buffer.computed);
+        UDO_ASSERT_EQ(line, expected.size() - 1);
+        UDO_ASSERT_EQ(column, 3u);
+        UDO_ASSERT_TRUE(buffer.line_starts == expected);
+        UDO_ASSERT_EQ(buffer.line_starts.capacity(), expected.size());
+    });
+
+    storage_suite->add_test("buffers_are_added_concurrently", []() {
+        Source_Manager sources;
+        const Buffer* first = sources.getBuffer(sources.add_buffer("first"));
+        constexpr int threads = 4, per_thread = 300;
+
+        std::vector<std::vector<FileID>> added(threads);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&sources, &added, t]() {
+                for (int i = 0; i < per_thread; ++i) {
+                    const std::string text = std::to_string(t) + ":" + std::to_string(i);
+                    const FileID id = sources.add_buffer(text);
+                    added[t].push_back(id);
+                    // reads take no lock and see the buffer as soon as add_buffer returns
+                    const Buffer* buffer = sources.getBuffer(id);
+                    if (!buffer || buffer->text() != text) return;
+                    if (sources.get_file_id(sources.get_location(id, text.size())) != id) return;
+                }
+            });
+        }
+        for (auto& worker : workers) worker.join();
+
+        std::vector<FileID> ids;
+        for (int t = 0; t < threads; ++t) {
+            UDO_ASSERT_EQ(added[t].size(), static_cast<std::size_t>(per_thread));
+            for (int i = 0; i < per_thread; ++i) {
+                UDO_ASSERT_STREQ(sources.getBuffer(added[t][i])->text(), std::to_string(t) + ":" + std::to_string(i));
+            }
+            ids.insert(ids.end(), added[t].begin(), added[t].end());
+        }
+        std::ranges::sort(ids);
+        UDO_ASSERT_TRUE(std::ranges::adjacent_find(ids) == ids.end());
+        // the first buffer never moved while the table grew
+        UDO_ASSERT_EQ(sources.getBuffer(1), first);
+        UDO_ASSERT_STREQ(first->text(), "first");
+    });
+
+    storage_suite->add_test("files_from_disk_are_mapped", []() {
+        // exactly one page, so a read past the end of the mapping would fault
+        std::string input;
+        while (input.size() + 7 <= 4096 - 7) input += "let x;\n";
+        input.resize(4096 - 7, ' ');
+        input += "\nending";
+        const std::string path = (std::filesystem::temp_directory_path() / "udo_lexer_mapped.udo").string();
+        std::ofstream(path, std::ios::binary) << input;
+
+        Source_Manager sources;
+        diag::DiagnosticsEngine diag;
+        const FileID file = sources.add_file_from_disk(path, diag);
+        Buffer& buffer = *sources.getBuffer(file);
+        UDO_ASSERT_TRUE(buffer.is_mapped());
+        UDO_ASSERT_TRUE(buffer.data.empty());
+        UDO_ASSERT_STREQ(buffer.text(), input);
+
+        Lexer lexer(buffer, file);
+        auto tokens = lexer.tokenize();
+        // ..., ending, newline, eof
+        UDO_ASSERT_STREQ(tokens.lexeme(tokens.size() - 3), "ending");
+        UDO_ASSERT_EQ(tokens.lexeme(0).data(), buffer.text().data());
+        UDO_ASSERT_EQ(buffer.get_line_column(4095).first, static_cast<Line>(std::ranges::count(input, '\n') + 1));
+
+        // the first edit copies the contents out of the mapping
+        Lexer::relex(buffer, file, tokens, {0, 3, "var"});
+        UDO_ASSERT_FALSE(buffer.is_mapped());
+        UDO_ASSERT_STREQ(buffer.data.substr(0, 6), "var x;");
+        UDO_ASSERT_STREQ(tokens.lexeme(0), "var");
+
+        std::ofstream(path, std::ios::binary | std::ios::trunc).flush();
+        const FileID empty = sources.add_file_from_disk(path, diag);
+        UDO_ASSERT_FALSE(sources.getBuffer(empty)->is_mapped());
+        UDO_ASSERT_TRUE(sources.getBuffer(empty)->text().empty());
+        std::filesystem::remove(path);
+    });
+
+    storage_suite->add_test("files_from_disk_are_loaded_once", []() {
+        const auto dir = std::filesystem::temp_directory_path();
+        const std::string path = (dir / "udo_lexer_once.udo").string();
+        const std::string copy = (dir / "udo_lexer_once_copy.udo").string();
+        std::ofstream(path, std::ios::binary) << "let x = 1;\n";
+        std::ofstream(copy, std::ios::binary) << "let x = 1;\n";
+
+        Source_Manager sources;
+        diag::DiagnosticsEngine diag;
+        const FileID file = sources.add_file_from_disk(path, diag);
+        UDO_ASSERT_NE(file, 0u);
+        UDO_ASSERT_EQ(sources.add_file_from_disk(path, diag), file);
+        UDO_ASSERT_EQ(sources.add_file_from_disk((dir / "." / "udo_lexer_once.udo").string(), diag), file);
+        UDO_ASSERT_EQ(sources.find_file(path), file);
+        UDO_ASSERT_EQ(sources.find_file((dir / "udo_lexer_never.udo").string()), 0u);
+
+        // same contents under another path share the contents, but not the FileID, path or buffer
+        const FileID copied = sources.add_file_from_disk(copy, diag);
+        UDO_ASSERT_NE(copied, file);
+        UDO_ASSERT_EQ(sources.find_file(copy), copied);
+        UDO_ASSERT_EQ(sources.getBuffer(copied)->text().data(), sources.getBuffer(file)->text().data());
+        UDO_ASSERT_EQ(sources.getFilePath(sources.get_location(copied, 4)), copy);
+        UDO_ASSERT_EQ(sources.getFilePath(sources.get_location(file, 4)), path);
+
+        // editing one of them leaves the other alone
+        Buffer& edited = *sources.getBuffer(copied);
+        TokenStream tokens = Lexer(edited, copied).tokenize();
+        Lexer::relex(edited, copied, tokens, {8, 1, "7"});
+        UDO_ASSERT_STREQ(sources.getBuffer(copied)->text(), "let x = 7;\n");
+        UDO_ASSERT_STREQ(sources.getBuffer(file)->text(), "let x = 1;\n");
+
+        // a file that changed on disk is loaded again, replaced the way editors save it so the old
+        // mapping keeps the old contents
+        const std::string saved = (dir / "udo_lexer_once.udo.tmp").string();
+        std::ofstream(saved, std::ios::binary) << "let x = 22;\n";
+        std::filesystem::rename(saved, path);
+        const FileID changed = sources.add_file_from_disk(path, diag);
+        UDO_ASSERT_NE(changed, file);
+        UDO_ASSERT_STREQ(sources.getBuffer(changed)->text(), "let x = 22;\n");
+        UDO_ASSERT_STREQ(sources.getBuffer(file)->text(), "let x = 1;\n");
+        UDO_ASSERT_EQ(sources.find_file(path), changed);
+
+        std::filesystem::remove(path);
+        std::filesystem::remove(copy);
+    });
+
+    storage_suite->add_test("prefetched_sources_arrive_in_order", []() {
+        const auto dir = std::filesystem::temp_directory_path();
+        std::vector<std::string> paths;
+        for (int i = 0; i < 6; ++i) {
+            paths.push_back((dir / ("udo_lexer_prefetch_" + std::to_string(i) + ".udo")).string());
+            std::ofstream(paths.back(), std::ios::binary) << "let v" << i << " = " << i << ";\n";
+        }
+        const std::string missing = (dir / "udo_lexer_prefetch_missing.udo").string();
+
+        Source_Manager sources;
+        {
+            // a one byte budget holds at most one file ahead
+            Source_Prefetcher prefetcher(sources, 1);
+            for (const auto& path : paths) prefetcher.enqueue(path);
+            prefetcher.enqueue(missing);
+
+            for (int i = 0; i < 6; ++i) {
+                const File_Load load = prefetcher.take(paths[i]);
+                UDO_ASSERT_FALSE(load.diagnostic.has_value());
+                UDO_ASSERT_STREQ(sources.getBuffer(load.id)->text(),
+                                 "let v" + std::to_string(i) + " = " + std::to_string(i) + ";\n");
+            }
+            const File_Load failed = prefetcher.take(missing);
+            UDO_ASSERT_EQ(failed.id, static_cast<FileID>(SOURCE_MANAGER_INVALID_FILE_ID));
+            UDO_ASSERT_TRUE(failed.diagnostic == diag::common::err_file_not_found);
+
+            // taking a file again hands back the same load
+            UDO_ASSERT_EQ(prefetcher.take(paths[2]).id, sources.find_file(paths[2]));
+            UDO_ASSERT_NE(sources.find_file(paths[2]), 0u);
+        }
+        for (const auto& path : paths) std::filesystem::remove(path);
+    });
+
+    storage_suite->add_test("released_sources_are_evicted_and_read_back", []() {
+        const auto dir = std::filesystem::temp_directory_path();
+        const std::string first_path = (dir / "udo_lexer_evict_first.udo").string();
+        const std::string second_path = (dir / "udo_lexer_evict_second.udo").string();
+        std::ofstream(first_path, std::ios::binary) << "let a = 1;\nlet b = 2;\n";
+        std::ofstream(second_path, std::ios::binary) << "let c = 3;\n";
+
+        Source_Manager sources;
+        diag::DiagnosticsEngine diag;
+        const FileID first = sources.add_file_from_disk(first_path, diag);
+        const FileID second = sources.add_file_from_disk(second_path, diag);
+        const Source_Location b = sources.get_location(first, 11);
+
+        // one byte keeps nothing but the file a lookup is reading
+        sources.set_cache_limit(1);
+        sources.release(first);
+        UDO_ASSERT_TRUE(sources.getBuffer(first)->evicted);
+        UDO_ASSERT_TRUE(sources.getBuffer(first)->text().empty());
+        UDO_ASSERT_FALSE(sources.getBuffer(second)->evicted);
+
+        // a late diagnostic reads it back in
+        UDO_ASSERT_STREQ(sources.getLineText(b), "let b = 2;\n");
+        UDO_ASSERT_EQ(sources.getLineColumn(b).first, 2u);
+        UDO_ASSERT_FALSE(sources.getBuffer(first)->evicted);
+
+        sources.release(second);
+        UDO_ASSERT_TRUE(sources.getBuffer(first)->evicted);
+        UDO_ASSERT_TRUE(sources.getBuffer(second)->evicted);
+
+        // loading a released file again takes it back, contents and all
+        UDO_ASSERT_EQ(sources.add_file_from_disk(second_path, diag), second);
+        UDO_ASSERT_FALSE(sources.getBuffer(second)->released);
+        UDO_ASSERT_STREQ(sources.getBuffer(second)->text(), "let c = 3;\n");
+
+        // contents that changed on disk are not passed off as the ones that were lexed
+        const std::string saved = first_path + ".tmp";
+        std::ofstream(saved, std::ios::binary) << "let a = 10;\nlet b = 20;\n";
+        std::filesystem::rename(saved, first_path);
+        UDO_ASSERT_EQ(sources.getLineColumn(b).first, 0u);
+        UDO_ASSERT_STREQ(sources.getLineText(b), "");
+        UDO_ASSERT_EQ(sources.getFilePath(b), first_path);
+
+        std::filesystem::remove(first_path);
+        std::filesystem::remove(second_path);
+    });
+
+    storage_suite->add_test("sources_handed_out_again_are_not_evicted", []() {
+        const auto dir = std::filesystem::temp_directory_path();
+        const std::string path = (dir / "udo_lexer_reuse.udo").string();
+        const std::string copy = (dir / "udo_lexer_reuse_copy.udo").string();
+        std::ofstream(path, std::ios::binary) << "let a = 1;\n";
+        std::ofstream(copy, std::ios::binary) << "let a = 1;\n";
+
+        Source_Manager sources;
+        diag::DiagnosticsEngine diag;
+        sources.set_cache_limit(1);
+        const FileID file = sources.add_file_from_disk(path, diag);
+        UDO_ASSERT_EQ(sources.add_file_from_disk(path, diag), file);
+
+        // the second load is still using it after the first is done with it
+        sources.release(file);
+        UDO_ASSERT_FALSE(sources.getBuffer(file)->released);
+        auto tokens = Lexer(*sources.getBuffer(file), file).tokenize();
+        UDO_ASSERT_STREQ(tokens.lexeme(1), "a");
+        sources.release(file);
+        UDO_ASSERT_TRUE(sources.getBuffer(file)->evicted);
+        // positions are still resolved once the contents are gone, read back in through the manager
+        UDO_ASSERT_EQ(tokens.line_column(1, sources).first, 1u);
+        UDO_ASSERT_EQ(tokens.line_column(1, sources).second, 5u);
+
+        // a copy loaded while the original is evicted reads its own contents
+        const FileID copied = sources.add_file_from_disk(copy, diag);
+        UDO_ASSERT_STREQ(sources.getBuffer(copied)->text(), "let a = 1;\n");
+        UDO_ASSERT_STREQ(Lexer(*sources.getBuffer(copied), copied).tokenize().lexeme(1), "a");
+
+        // taking a released file from the prefetcher again reads it back in before it is lexed
+        {
+            Source_Prefetcher prefetcher(sources, 1);
+            prefetcher.enqueue(copy);
+            const FileID taken = prefetcher.take(copy).id;
+            UDO_ASSERT_EQ(taken, copied);
+            sources.release(taken);
+            sources.release(taken);
+            UDO_ASSERT_TRUE(sources.getBuffer(taken)->evicted);
+
+            UDO_ASSERT_EQ(prefetcher.take(copy).id, taken);
+            UDO_ASSERT_FALSE(sources.getBuffer(taken)->released);
+            UDO_ASSERT_STREQ(Lexer(*sources.getBuffer(taken), taken).tokenize().lexeme(1), "a");
+            sources.release(taken);
+            UDO_ASSERT_TRUE(sources.getBuffer(taken)->evicted);
+        }
+
+        std::filesystem::remove(path);
+        std::filesystem::remove(copy);
+    });
+
+    storage_suite->add_test("overlays_shadow_files_on_disk", []() {
+        const auto dir = std::filesystem::temp_directory_path();
+        const std::string edited = (dir / "udo_lexer_overlay_edited.udo").string();
+        const std::string other = (dir / "udo_lexer_overlay_other.udo").string();
+        const std::string unsaved = (dir / "udo_lexer_overlay_unsaved.udo").string();
+        std::ofstream(edited, std::ios::binary) << "let x = 1;\n";
+        std::ofstream(other, std::ios::binary) << "let y = 2;\n";
+
+        Source_Manager sources;
+        diag::DiagnosticsEngine diag;
+        const FileID on_disk = sources.add_file_from_disk(edited, diag);
+        const FileID untouched = sources.add_file_from_disk(other, diag);
+        UDO_ASSERT_EQ(sources.overlay_generation(edited), 0u);
+
+        const std::uint64_t first = sources.set_overlay(edited, "let x = 10;\n");
+        const FileID overlaid = sources.add_file_from_disk(edited, diag);
+        UDO_ASSERT_NE(overlaid, on_disk);
+        UDO_ASSERT_STREQ(sources.getBuffer(overlaid)->text(), "let x = 10;\n");
+        UDO_ASSERT_EQ(sources.add_file_from_disk(edited, diag), overlaid);
+        UDO_ASSERT_EQ(sources.add_file_from_disk(other, diag), untouched);
+
+        // each edit is a new generation with a buffer of its own, older locations still resolve
+        const std::uint64_t second = sources.set_overlay(edited, "let x = 100;\n");
+        UDO_ASSERT_GT(second, first);
+        UDO_ASSERT_EQ(sources.overlay_generation(edited), second);
+        const FileID reedited = sources.add_file_from_disk(edited, diag);
+        UDO_ASSERT_NE(reedited, overlaid);
+        UDO_ASSERT_STREQ(sources.getBuffer(reedited)->text(), "let x = 100;\n");
+        UDO_ASSERT_STREQ(sources.getLineText(sources.get_location(overlaid, 0)), "let x = 10;\n");
+
+        // a file that was never saved at all
+        sources.set_overlay(unsaved, "let z = 3;\n");
+        const File_Load load = sources.load_file(unsaved);
+        UDO_ASSERT_FALSE(load.diagnostic.has_value());
+        UDO_ASSERT_STREQ(sources.getBuffer(load.id)->text(), "let z = 3;\n");
+
+        // dropping the overlay goes back to the cached buffer from disk
+        sources.remove_overlay(edited);
+        UDO_ASSERT_EQ(sources.overlay_generation(edited), 0u);
+        UDO_ASSERT_STREQ(sources.getBuffer(sources.add_file_from_disk(edited, diag))->text(), "let x = 1;\n");
+        sources.remove_overlay(unsaved);
+        UDO_ASSERT_TRUE(sources.load_file(unsaved).diagnostic == diag::common::err_file_not_found);
+
+        std::filesystem::remove(edited);
+        std::filesystem::remove(other);
+    });
+
+    runner.add_suite(std::move(storage_suite));
+
+    // ========================================================================
+    // Character Scanner Tests
+    // ========================================================================
+
+    auto scan_suite = std::make_unique<TestSuite>("Lexer::CharScanners");
+
+    scan_suite->add_test("vector_scanners_match_scalar", []() {
+        const Char_Scanners* scalar = get_scanners(Scan_ISA::scalar);
+        UDO_ASSERT_NOT_NULL(scalar);
+
+        // runs that end before, on and across 16 and 32 byte block boundaries, plus non-ASCII bytes
+        std::vector<std::string> inputs = {"", " ", "a", "\n"};
+        for (std::size_t len : {3u, 15u, 16u, 17u, 31u, 32u, 33u, 64u, 70u}) {
+            inputs.push_back(std::string(len, ' ') + "x");
+            inputs.push_back(std::string(len, '\t') + "\v\f\r\n ");
+            inputs.push_back(std::string(len, 'z') + "Az_09" + "\xC3\xA9" + "q");
+            inputs.push_back(std::string(len, '7') + "0123456789" + "a");
+            inputs.push_back(std::string(len, 'k') + "\n" + "tail");
+            inputs.push_back(std::string(len, '@') + "`[{/:");
+            inputs.push_back(std::string(len, 'q') + "'\\\"" + "x");
+        }
+
+        for (Scan_ISA isa : {Scan_ISA::sse2, Scan_ISA::avx2}) {
+            const Char_Scanners* scanners = get_scanners(isa);
+            if (!scanners) continue;
+            for (const std::string& in : inputs) {
+                for (std::size_t pos = 0; pos <= in.size(); pos += 5) {
+                    UDO_ASSERT_EQ(scanners->skip_whitespace(in.data(), pos, in.size()), scalar->skip_whitespace(in.data(), pos, in.size()));
+                    UDO_ASSERT_EQ(scanners->identifier_end(in.data(), pos, in.size()), scalar->identifier_end(in.data(), pos, in.size()));
+                    UDO_ASSERT_EQ(scanners->digit_end(in.data(), pos, in.size()), scalar->digit_end(in.data(), pos, in.size()));
+                    UDO_ASSERT_EQ(scanners->find_newline(in.data(), pos, in.size()), scalar->find_newline(in.data(), pos, in.size()));
+                    UDO_ASSERT_EQ(scanners->find_string_stop(in.data(), pos, in.size()), scalar->find_string_stop(in.data(), pos, in.size()));
+                    UDO_ASSERT_EQ(scanners->find_char_stop(in.data(), pos, in.size()), scalar->find_char_stop(in.data(), pos, in.size()));
+                }
+            }
+        }
+    });
+
+    scan_suite->add_test("lexer_uses_the_scanners_it_is_given", []() {
+        const std::string input = "let " + std::string(40, 'x') + " = 1234567890123456789012345678901234;"
+                                + std::string(37, ' ') + "// tail\n\"" + std::string(50, 's') + "\"\n";
+        Buffer buffer(input, "scanners.udo");
+
+        Lexer reference(buffer);
+        reference.set_scanners(*get_scanners(Scan_ISA::scalar));
+        UDO_ASSERT_TRUE(reference.get_scanners().isa == Scan_ISA::scalar);
+        const TokenStream expected = reference.tokenize();
+
+        for (Scan_ISA isa : {Scan_ISA::sse2, Scan_ISA::avx2}) {
+            const Char_Scanners* scanners = get_scanners(isa);
+            if (!scanners) continue;
+            Lexer lexer(buffer);
+            lexer.set_scanners(*scanners);
+            const TokenStream tokens = lexer.tokenize();
+            UDO_ASSERT_EQ(tokens.size(), expected.size());
+            for (std::size_t i = 0; i < tokens.size(); ++i) {
+                UDO_ASSERT_TRUE(tokens.kind(i) == expected.kind(i));
+                UDO_ASSERT_EQ(tokens.lexeme(i), expected.lexeme(i));
+            }
+        }
+    });
+
+    scan_suite->add_test("char_classes_are_ascii_only", []() {
+        UDO_ASSERT_TRUE(is_space(' ') && is_space('\t') && is_space('\r'));
+        UDO_ASSERT_FALSE(is_space('\n'));
+        UDO_ASSERT_TRUE(is_ident_start('_') && is_ident_start('Q'));
+        UDO_ASSERT_FALSE(is_ident_start('5'));
+        UDO_ASSERT_TRUE(is_ident('5'));
+        UDO_ASSERT_FALSE(is_ident(static_cast<char>(0xC3)));
+        UDO_ASSERT_EQ(to_lower('X'), 'x');
+        UDO_ASSERT_EQ(to_lower('['), '[');
+    });
+
+    scan_suite->add_test("long_runs_lex_like_short_ones", []() {
+        std::string ident(100, 'a');
+        std::string digits(100, '1');
+        auto tokens = get_meaningful_tokens(tokenize_string(std::string(40, ' ') + ident + std::string(37, '\t') + digits + ";"));
+        UDO_ASSERT_EQ(tokens.size(), 3u);
+        UDO_ASSERT_STREQ(tokens[0].lexeme, ident);
+        UDO_ASSERT_STREQ(tokens[1].lexeme, digits);
+        UDO_ASSERT_EQ(static_cast<int>(tokens[2].type), static_cast<int>(TokenType::semicolon));
+    });
+
+    runner.add_suite(std::move(scan_suite));
+
+    // ========================================================================
+    // Streaming Tests
+    // ========================================================================
+
+    auto stream_suite = std::make_unique<TestSuite>("Lexer::Streaming");
+
+    stream_suite->add_test("next_token_matches_tokenize", []() {
+        Buffer buffer;
+        buffer.data = "let x: i32 = 0x1F;\n  fn f() {}\n@ 3.5f";
+        Lexer lexer(buffer, 2);
+        auto tokens = lexer.tokenize();
+        for (std::size_t i = 0; i < tokens.size(); ++i) {
+            const Token t = lexer.next_token();
+            UDO_ASSERT_EQ(static_cast<int>(t.type), static_cast<int>(tokens.kind(i)));
+            UDO_ASSERT_EQ(t.lexeme.data(), tokens.lexeme(i).data());
+            UDO_ASSERT_EQ(t.lexeme.size(), tokens.lexeme(i).size());
+            UDO_ASSERT_EQ(t.location.offset, tokens.location(i).offset);
+        }
+        // eof repeats once the buffer is exhausted
+        UDO_ASSERT_EQ(static_cast<int>(lexer.next_token().type), static_cast<int>(TokenType::eof));
+        UDO_ASSERT_EQ(static_cast<int>(lexer.peek().type), static_cast<int>(TokenType::eof));
+    });
+
+    stream_suite->add_test("peek_does_not_consume", []() {
+        Buffer buffer;
+        buffer.data = "a b c d";
+        Lexer lexer(buffer);
+        UDO_ASSERT_STREQ(lexer.peek(2).lexeme, "c");
+        UDO_ASSERT_STREQ(lexer.peek().lexeme, "a");
+        UDO_ASSERT_EQ(static_cast<int>(lexer.previous().type), static_cast<int>(TokenType::invalid_token));
+        UDO_ASSERT_STREQ(lexer.next_token().lexeme, "a");
+        UDO_ASSERT_STREQ(lexer.previous().lexeme, "a");
+        UDO_ASSERT_STREQ(lexer.peek(1).lexeme, "c");
+        UDO_ASSERT_STREQ(lexer.next_token().lexeme, "b");
+        UDO_ASSERT_STREQ(lexer.next_token().lexeme, "c");
+        UDO_ASSERT_STREQ(lexer.next_token().lexeme, "d");
+    });
+
+    stream_suite->add_test("lookahead_window_wraps", []() {
+        // walk a full window ahead at every step so the ring wraps many times over
+        std::string input;
+        for (int i = 0; i < 100; ++i) input += "t" + std::to_string(i) + " ";
+        Buffer buffer;
+        buffer.data = input;
+        Lexer lexer(buffer);
+        for (int i = 0; i < 100; ++i) {
+            const Token ahead = lexer.peek(Lexer::max_lookahead - 1);
+            if (i + Lexer::max_lookahead - 1 < 100) {
+                UDO_ASSERT_STREQ(ahead.lexeme, "t" + std::to_string(i + Lexer::max_lookahead - 1));
+            }
+            UDO_ASSERT_STREQ(lexer.next_token().lexeme, "t" + std::to_string(i));
+        }
+        UDO_ASSERT_EQ(static_cast<int>(lexer.next_token().type), static_cast<int>(TokenType::newline));
+        UDO_ASSERT_EQ(static_cast<int>(lexer.next_token().type), static_cast<int>(TokenType::eof));
+    });
+
+    stream_suite->add_test("token_stream_reader_replays_stream", []() {
+        auto tokens = tokenize_string("let x");
+        TokenStream_Reader reader(tokens);
+        UDO_ASSERT_EQ(static_cast<int>(reader.peek(1).type), static_cast<int>(TokenType::identifier));
+        UDO_ASSERT_EQ(static_cast<int>(reader.next_token().type), static_cast<int>(TokenType::kw_let));
+        UDO_ASSERT_STREQ(reader.previous().lexeme, "let");
+        reader.next_token();
+        reader.next_token();
+        UDO_ASSERT_EQ(static_cast<int>(reader.next_token().type), static_cast<int>(TokenType::eof));
+        UDO_ASSERT_EQ(static_cast<int>(reader.next_token().type), static_cast<int>(TokenType::eof));
+    });
+
+    stream_suite->add_test("comments_are_left_out_of_token_sources", []() {
+        Buffer buffer;
+        buffer.data = "let /* a */ /* b */ x // c\n";
+        Lexer lexer(buffer);
+        UDO_ASSERT_STREQ(lexer.peek(1).lexeme, "x");
+        UDO_ASSERT_EQ(static_cast<int>(lexer.next_token().type), static_cast<int>(TokenType::kw_let));
+        UDO_ASSERT_STREQ(lexer.next_token().lexeme, "x");
+        UDO_ASSERT_EQ(static_cast<int>(lexer.next_token().type), static_cast<int>(TokenType::newline));
+
+        // the full stream keeps them, a reader over it does not
+        auto tokens = tokenize_string("/* a */ let /* b */ x // c");
+        UDO_ASSERT_EQ(tokens.size(), 7u);
+        TokenStream_Reader reader(tokens);
+        UDO_ASSERT_STREQ(reader.peek(1).lexeme, "x");
+        UDO_ASSERT_EQ(static_cast<int>(reader.peek(2).type), static_cast<int>(TokenType::newline));
+        UDO_ASSERT_EQ(static_cast<int>(reader.next_token().type), static_cast<int>(TokenType::kw_let));
+        UDO_ASSERT_STREQ(reader.next_token().lexeme, "x");
+        UDO_ASSERT_STREQ(reader.previous().lexeme, "x");
+        UDO_ASSERT_EQ(static_cast<int>(reader.next_token().type), static_cast<int>(TokenType::newline));
+        UDO_ASSERT_EQ(static_cast<int>(reader.next_token().type), static_cast<int>(TokenType::eof));
+    });
+
+    stream_suite->add_test("stray_backslash_is_not_a_comment", []() {
+        Buffer buffer;
+        buffer.data = "let x \\ = 1;";
+        Lexer lexer(buffer);
+        lexer.next_token();
+        lexer.next_token();
+        const Token stray = lexer.next_token();
+        UDO_ASSERT_EQ(static_cast<int>(stray.type), static_cast<int>(TokenType::unknown));
+        UDO_ASSERT_STREQ(stray.lexeme, "\\");
+
+        auto tokens = tokenize_string(buffer.data);
+        TokenStream_Reader reader(tokens);
+        UDO_ASSERT_EQ(static_cast<int>(reader.peek(2).type), static_cast<int>(TokenType::unknown));
+    });
+
+    runner.add_suite(std::move(stream_suite));
+
+    // ========================================================================
+    // Token Channel Tests
+    // ========================================================================
+
+    auto channel_suite = std::make_unique<TestSuite>("Lexer::TokenChannel");
+
+    channel_suite->add_test("consumer_sees_lexer_order", []() {
+        // more tokens than the ring holds, so the producer has to wait on the consumer
+        std::string input;
+        for (int i = 0; i < 3000; ++i) input += "let v" + std::to_string(i) + " = " + std::to_string(i) + ";\n";
+        Buffer buffer;
+        buffer.data = input;
+        const auto tokens = Lexer(buffer).tokenize();
+        UDO_ASSERT_TRUE(tokens.size() > Token_Channel::capacity);
+
+        Lexer lexer(buffer);
+        Token_Channel channel;
+        std::thread producer([&] { channel.produce_from(lexer); });
+
+        bool matches = true;
+        for (std::size_t i = 0; i < tokens.size(); ++i) {
+            if (i + 3 < tokens.size() && channel.peek(3).location.offset != tokens.location(i + 3).offset) matches = false;
+            const Token t = channel.next_token();
+            if (t.type != tokens.kind(i) || t.lexeme.data() != tokens.lexeme(i).data()) matches = false;
+            if (t.type == TokenType::int_literal) {
+                const Numeric_Literal* value = channel.literal(t);
+                if (!value || value->integer != tokens.literal(i)->integer) matches = false;
+            }
+        }
+        producer.join();
+        UDO_ASSERT_TRUE(matches);
+        UDO_ASSERT_EQ(static_cast<int>(channel.next_token().type), static_cast<int>(TokenType::eof));
+        UDO_ASSERT_EQ(static_cast<int>(channel.peek(5).type), static_cast<int>(TokenType::eof));
+    });
+
+    channel_suite->add_test("peek_past_eof_repeats_eof", []() {
+        Buffer buffer;
+        buffer.data = "a b";
+        Lexer lexer(buffer);
+        Token_Channel channel;
+        std::thread producer([&] { channel.produce_from(lexer); });
+        UDO_ASSERT_EQ(static_cast<int>(channel.peek(10).type), static_cast<int>(TokenType::eof));
+        UDO_ASSERT_STREQ(channel.peek(1).lexeme, "b");
+        UDO_ASSERT_STREQ(channel.next_token().lexeme, "a");
+        UDO_ASSERT_STREQ(channel.previous().lexeme, "a");
+        producer.join();
+    });
+
+    channel_suite->add_test("cancel_releases_blocked_producer", []() {
+        std::string input;
+        for (int i = 0; i < 10000; ++i) input += "x ";
+        Buffer buffer;
+        buffer.data = input;
+        Lexer lexer(buffer);
+        Token_Channel channel;
+        std::thread producer([&] { channel.produce_from(lexer); });
+        UDO_ASSERT_STREQ(channel.next_token().lexeme, "x");
+        channel.cancel();
+        producer.join();   // would hang if the full ring kept the producer waiting
+    });
+
+    runner.add_suite(std::move(channel_suite));
+
+    // ========================================================================
+    // Parallel Lexing Tests
+    // ========================================================================
+
+    auto parallel_suite = std::make_unique<TestSuite>("Lexer::Parallel");
+
+    // lexes `input` once on the calling thread and once split into small chunks, expecting identical results
+    static const auto expect_same_as_sequential = [](const std::string& input, const Parallel_Options& options) {
+        Buffer buffer;
+        buffer.data = input;
+
+        Lexer sequential(buffer);
+        Trivia_Table sequential_trivia;
+        auto expected = sequential.tokenize(sequential_trivia);
+
+        Lexer chunked(buffer);
+        chunked.set_parallel_options(options);
+        Trivia_Table chunked_trivia;
+        auto actual = chunked.tokenize(chunked_trivia);
+
+        UDO_ASSERT_EQ(actual.size(), expected.size());
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            UDO_ASSERT_EQ(static_cast<int>(actual.kind(i)), static_cast<int>(expected.kind(i)));
+            UDO_ASSERT_EQ(actual.offset(i), expected.offset(i));
+            UDO_ASSERT_EQ(actual.length(i), expected.length(i));
+        }
+        UDO_ASSERT_EQ(chunked_trivia.size(), sequential_trivia.size());
+        for (std::size_t i = 0; i < sequential_trivia.size(); ++i) {
+            UDO_ASSERT_EQ(chunked_trivia.token_index(i), sequential_trivia.token_index(i));
+            UDO_ASSERT_EQ(chunked_trivia.offset(i), sequential_trivia.offset(i));
+            UDO_ASSERT_EQ(chunked_trivia.length(i), sequential_trivia.length(i));
+        }
+    };
+
+    parallel_suite->add_test("chunked_matches_sequential", []() {
+        std::string input;
+        for (int i = 0; i < 5000; ++i) {
+            input += "let v" + std::to_string(i) + ": i64 = " + std::to_string(i * 7) + "ull;  \n";
+            if (i % 13 == 0) input += "\n\t fn f() -> i32 { return 1.5e3f; }\n";
+        }
+        UDO_ASSERT_GT(input.size(), 100000u);
+        expect_same_as_sequential(input, {0, 4096, 8});
+    });
+
+    parallel_suite->add_test("more_threads_than_lines", []() {
+        expect_same_as_sequential("a\nb\n\n  c + d", {0, 1, 16});
+        expect_same_as_sequential("single line, no newline", {0, 1, 16});
+        expect_same_as_sequential("ends with newline\n", {0, 1, 16});
+    });
+
+    parallel_suite->add_test("small_buffers_stay_sequential", []() {
+        Buffer buffer;
+        buffer.data = "let x = 1;";
+        Lexer lexer(buffer);
+        UDO_ASSERT_GT(lexer.get_parallel_options().threshold, buffer.data.size());
+        UDO_ASSERT_EQ(lexer.tokenize().size(), 7u);
+    });
+
+    parallel_suite->add_test("block_comments_across_chunk_seams", []() {
+        // comments opened on one line and closed many lines (and chunks) later, with text inside them
+        // that would lex very differently outside a comment
+        std::string input;
+        for (int i = 0; i < 3000; ++i) {
+            input += "let v" + std::to_string(i) + " = \"s\\n\";\n";
+            if (i % 700 == 0) {
+                input += "/* open\n";
+                for (int j = 0; j < 150; ++j) input += "  \" ' let \"x\" 'y' // */ nope\n";
+                input += "*/ let after = 1;\n";
+            }
+        }
+        expect_same_as_sequential(input, {0, 4096, 8});
+        expect_same_as_sequential(input + "/* never closed\n" + input, {0, 4096, 8});
+    });
+
+    parallel_suite->add_test("chunked_literals_are_decoded_and_diagnosed_in_order", []() {
+        std::string input;
+        for (int i = 0; i < 2000; ++i) input += "let s = \"v\\t" + std::to_string(i) + "\"; '' \n";
+        Buffer buffer;
+        buffer.data = input;
+        Lexer chunked(buffer);
+        chunked.set_parallel_options({0, 4096, 8});
+        chunked.set_string_storage({nullptr, store_test_string});
+        auto tokens = chunked.tokenize();
+
+        std::size_t strings = 0;
+        bool decoded = true;
+        for (std::size_t i = 0; i < tokens.size(); ++i) {
+            if (tokens.kind(i) != TokenType::string_literal) continue;
+            const std::string_view* value = tokens.decoded_string(i);
+            decoded = decoded && value && *value == "v\t" + std::to_string(strings);
+            ++strings;
+        }
+        UDO_ASSERT_EQ(strings, 2000u);
+        UDO_ASSERT_TRUE(decoded);
+
+        const auto& diags = chunked.get_pending_diagnostics();
+        UDO_ASSERT_EQ(diags.size(), 2000u);
+        bool ordered = true;
+        for (std::size_t i = 1; i < diags.size(); ++i) ordered = ordered && diags[i - 1].location.offset < diags[i].location.offset;
+        UDO_ASSERT_TRUE(ordered);
+    });
+
+    runner.add_suite(std::move(parallel_suite));
+
+    // ========================================================================
+    // Incremental Re-lexing Tests
+    // ========================================================================
+
+    auto relex_suite = std::make_unique<TestSuite>("Lexer::Incremental");
+
+    // applies `edit` incrementally and checks the result against lexing the edited buffer from scratch
+    static const auto expect_relex_matches = [](Buffer& buffer, TokenStream& tokens, Trivia_Table& trivia, const Source_Edit& edit) {
+        const std::optional<Relex_Result> result = Lexer::relex(buffer, 0, tokens, edit, &trivia);
+        UDO_ASSERT_TRUE(result.has_value());
+
+        Lexer fresh(buffer);
+        Trivia_Table expected_trivia;
+        auto expected = fresh.tokenize(expected_trivia);
+
+        UDO_ASSERT_EQ(tokens.size(), expected.size());
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            UDO_ASSERT_EQ(static_cast<int>(tokens.kind(i)), static_cast<int>(expected.kind(i)));
+            UDO_ASSERT_EQ(tokens.offset(i), expected.offset(i));
+            UDO_ASSERT_EQ(tokens.length(i), expected.length(i));
+        }
+        UDO_ASSERT_EQ(trivia.size(), expected_trivia.size());
+        for (std::size_t i = 0; i < expected_trivia.size(); ++i) {
+            UDO_ASSERT_EQ(trivia.token_index(i), expected_trivia.token_index(i));
+            UDO_ASSERT_EQ(trivia.offset(i), expected_trivia.offset(i));
+            UDO_ASSERT_EQ(trivia.length(i), expected_trivia.length(i));
+        }
+        return *result;
+    };
+
+    relex_suite->add_test("edit_relexes_only_its_line", []() {
+        Buffer buffer;
+        for (int i = 0; i < 1000; ++i) buffer.data += "let x" + std::to_string(i) + " = " + std::to_string(i) + ";\n";
+        Lexer lexer(buffer);
+        Trivia_Table trivia;
+        auto tokens = lexer.tokenize(trivia);
+
+        // "let x500 = 500;" becomes "let x500 = 5000 + y;"
+        const std::size_t at = buffer.data.find("500;") + 3;
+        const Relex_Result result = expect_relex_matches(buffer, tokens, trivia, {at, 0, "0 + y"});
+        UDO_ASSERT_EQ(result.removed_tokens, 6u);
+        UDO_ASSERT_EQ(result.inserted_tokens, 8u);
+        UDO_ASSERT_STREQ(tokens.lexeme(result.first_token + 3), "5000");
+    });
+
+    relex_suite->add_test("edits_that_add_and_join_lines", []() {
+        Buffer buffer;
+        buffer.data = "fn f() {\n    return 1;\n}\n";
+        Lexer lexer(buffer);
+        Trivia_Table trivia;
+        auto tokens = lexer.tokenize(trivia);
+
+        expect_relex_matches(buffer, tokens, trivia, {9, 0, "let a = 2;\n    "});
+        expect_relex_matches(buffer, tokens, trivia, {buffer.data.find('\n'), 1, " "});
+        expect_relex_matches(buffer, tokens, trivia, {0, 0, "\n\n"});
+        expect_relex_matches(buffer, tokens, trivia, {buffer.data.size(), 0, "x"});
+        expect_relex_matches(buffer, tokens, trivia, {buffer.data.size() - 1, 1, ""});
+        expect_relex_matches(buffer, tokens, trivia, {0, buffer.data.size(), ""});
+        UDO_ASSERT_EQ(tokens.size(), 1u);
+    });
+
+    relex_suite->add_test("random_edits_match_full_lex", []() {
+        Buffer buffer;
+        for (int i = 0; i < 50; ++i) buffer.data += "let v" + std::to_string(i) + ": i32 = 0x" + std::to_string(i) + "  + 1.5f;\n";
+        Lexer lexer(buffer);
+        Trivia_Table trivia;
+        auto tokens = lexer.tokenize(trivia);
+
+        const std::string_view snippets[] = {"", " ", "\n", "foo", "12.5e", "<<= ", "\t\n\n", "let", "0b1_0"};
+        std::uint32_t seed = 12345;
+        const auto next = [&seed](const std::size_t bound) {
+            seed = seed * 1664525u + 1013904223u;
+            return bound == 0 ? 0 : (seed >> 8) % bound;
+        };
+
+        for (int round = 0; round < 300; ++round) {
+            const std::size_t offset = next(buffer.data.size() + 1);
+            const std::size_t removed = next(std::min<std::size_t>(12, buffer.data.size() - offset) + 1);
+            expect_relex_matches(buffer, tokens, trivia, {offset, removed, snippets[next(std::size(snippets))]});
+        }
+    });
+
+    relex_suite->add_test("edits_that_open_and_close_block_comments", []() {
+        Buffer buffer;
+        buffer.data = "let a = 1;\nlet b = 2;\n/* c\nlet d = 4;\n*/\nlet e = 5;\nlet f = 6;\n";
+        Lexer lexer(buffer);
+        Trivia_Table trivia;
+        auto tokens = lexer.tokenize(trivia);
+
+        // close the comment early, then open a new one before it, then edit inside it
+        expect_relex_matches(buffer, tokens, trivia, {buffer.data.find(" c") + 2, 0, " */"});
+        expect_relex_matches(buffer, tokens, trivia, {buffer.data.find("let b"), 0, "/* "});
+        expect_relex_matches(buffer, tokens, trivia, {buffer.data.find("let d"), 3, "var"});
+        // remove both openers, so everything is code again
+        expect_relex_matches(buffer, tokens, trivia, {buffer.data.find("/* "), 3, ""});
+        expect_relex_matches(buffer, tokens, trivia, {buffer.data.find("/* c"), 2, ""});
+        UDO_ASSERT_EQ(static_cast<int>(tokens.kind(tokens.size() - 2)), static_cast<int>(TokenType::newline));
+    });
+
+    relex_suite->add_test("edits_stay_within_the_buffers_slice", []() {
+        Source_Manager sources;
+        const FileID file = sources.add_buffer("let a = 10;\n", "a.udo");
+        const FileID next = sources.add_buffer("let b = 2;\n", "b.udo");
+        Buffer& buffer = *sources.getBuffer(file);
+        auto tokens = Lexer(buffer, file).tokenize();
+        const std::size_t count = tokens.size();
+
+        // growing would put the eof location in the next file, so nothing is touched
+        UDO_ASSERT_FALSE(Lexer::relex(buffer, file, tokens, {8, 2, "100"}).has_value());
+        UDO_ASSERT_STREQ(buffer.text(), "let a = 10;\n");
+        UDO_ASSERT_EQ(tokens.size(), count);
+
+        // shrinking, and growing back to the slice it was given, both fit
+        UDO_ASSERT_TRUE(Lexer::relex(buffer, file, tokens, {8, 2, "7"}).has_value());
+        UDO_ASSERT_TRUE(Lexer::relex(buffer, file, tokens, {8, 1, "42"}).has_value());
+        UDO_ASSERT_STREQ(tokens.lexeme(3), "42");
+        UDO_ASSERT_EQ(sources.get_file_id(tokens.location(tokens.size() - 1)), file);
+        UDO_ASSERT_STREQ(sources.getBuffer(next)->text(), "let b = 2;\n");
+    });
+
+    relex_suite->add_test("edits_decode_strings_and_report_errors", []() {
+        Buffer buffer;
+        buffer.data = "let a = \"x\";\nlet b = 2;\n";
+        Lexer lexer(buffer);
+        lexer.set_string_storage({nullptr, store_test_string});
+        auto tokens = lexer.tokenize();
+
+        std::optional<Relex_Result> result = Lexer::relex(buffer, 0, tokens, {buffer.data.find("x"), 1, "a\\tb"},
+                                                          nullptr, nullptr, {nullptr, store_test_string});
+        UDO_ASSERT_TRUE(result->diagnostics.empty());
+        UDO_ASSERT_NOT_NULL(tokens.decoded_string(3));
+        UDO_ASSERT_STREQ(*tokens.decoded_string(3), "a\tb");
+
+        // errors in the re-lexed lines are handed back, at their place in the edited buffer
+        result = Lexer::relex(buffer, 0, tokens, {buffer.data.find("2;"), 0, "'"}, nullptr, nullptr,
+                              {nullptr, store_test_string});
+        UDO_ASSERT_EQ(result->diagnostics.size(), 1u);
+        UDO_ASSERT_EQ(result->diagnostics[0].id, diag::lex::err_unterminated_char);
+        UDO_ASSERT_EQ(result->diagnostics[0].location.offset, buffer.data.find("'"));
+    });
+
+    runner.add_suite(std::move(relex_suite));
+
+    // ========================================================================
+    // Numeric Literal Value Tests
+    // ========================================================================
+
+    auto literal_suite = std::make_unique<TestSuite>("Lexer::LiteralValues");
+
+    // lexes a single literal and returns its decoded value
+    static const auto decode = [](const std::string& input) {
+        auto tokens = tokenize_string(input);
+        UDO_ASSERT_TRUE(tokens.kind(0) == TokenType::int_literal || tokens.kind(0) == TokenType::float_literal);
+        const Numeric_Literal* literal = tokens.literal(0);
+        UDO_ASSERT_NOT_NULL(literal);
+        return *literal;
+    };
+
+    literal_suite->add_test("integers_in_every_base", []() {
+        UDO_ASSERT_EQ(decode("42").integer.low, 42u);
+        UDO_ASSERT_EQ(decode("1_000'000").integer.low, 1000000u);
+        UDO_ASSERT_EQ(decode("0xFF_ff").integer.low, 0xFFFFu);
+        UDO_ASSERT_EQ(decode("0xFF").base, 16u);
+        UDO_ASSERT_EQ(decode("0b1010").integer.low, 10u);
+        UDO_ASSERT_EQ(decode("0o17").integer.low, 15u);
+        UDO_ASSERT_EQ(decode("0755").integer.low, 0755u);
+        UDO_ASSERT_EQ(decode("0755").base, 8u);
+    });
+
+    literal_suite->add_test("integers_up_to_128_bits", []() {
+        const Numeric_Literal max_u64 = decode("18446744073709551615");
+        UDO_ASSERT_EQ(max_u64.integer.low, ~0ull);
+        UDO_ASSERT_TRUE(max_u64.integer.fits_u64());
+
+        const Numeric_Literal max_u128 = decode("0xFFFFFFFF_FFFFFFFF_FFFFFFFF_FFFFFFFF");
+        UDO_ASSERT_EQ(max_u128.integer.low, ~0ull);
+        UDO_ASSERT_EQ(max_u128.integer.high, ~0ull);
+        UDO_ASSERT_FALSE(max_u128.out_of_range);
+
+        const Numeric_Literal two_pow_64 = decode("18446744073709551616");
+        UDO_ASSERT_EQ(two_pow_64.integer.low, 0u);
+        UDO_ASSERT_EQ(two_pow_64.integer.high, 1u);
+
+        UDO_ASSERT_TRUE(decode("0x1_00000000_00000000_00000000_00000000").out_of_range);
+    });
+
+    literal_suite->add_test("floats_and_suffixes", []() {
+        const Numeric_Literal f = decode("1.5e3f");
+        UDO_ASSERT_TRUE(f.is_float);
+        UDO_ASSERT_EQ(f.floating, 1500.0);
+        UDO_ASSERT_EQ(f.suffix, ls_float);
+        UDO_ASSERT_EQ(decode("2.").floating, 2.0);
+        UDO_ASSERT_EQ(decode("1_0.2_5").floating, 10.25);
+        UDO_ASSERT_EQ(decode("0x1.8p1").floating, 3.0);
+        UDO_ASSERT_EQ(decode("3e2lf").suffix, ls_long | ls_float);
+        UDO_ASSERT_TRUE(decode("1e999").out_of_range);
+
+        UDO_ASSERT_EQ(decode("7ull").suffix, ls_unsigned | ls_long_long);
+        UDO_ASSERT_EQ(decode("7LU").suffix, ls_unsigned | ls_long);
+        UDO_ASSERT_EQ(decode("7zu").suffix, ls_unsigned | ls_size);
+        UDO_ASSERT_EQ(decode("7").suffix, ls_none);
+    });
+
+    literal_suite->add_test("only_literals_get_values", []() {
+        auto tokens = tokenize_string("x = 1 + 0x + 2.5");
+        UDO_ASSERT_EQ(tokens.literals().size(), 2u);
+        UDO_ASSERT_NULL(tokens.literal(0));
+        UDO_ASSERT_EQ(tokens.literal(2)->integer.low, 1u);
+    });
+
+    literal_suite->add_test("streaming_lexer_exposes_values", []() {
+        Buffer buffer;
+        buffer.data = "let a = 10 + 0x20;";
+        Lexer lexer(buffer);
+        const Token ahead = lexer.peek(5);
+        UDO_ASSERT_STREQ(ahead.lexeme, "0x20");
+        UDO_ASSERT_EQ(lexer.literal(ahead)->integer.low, 0x20u);
+        for (int i = 0; i < 4; ++i) lexer.next_token();
+        UDO_ASSERT_EQ(lexer.literal(lexer.previous())->integer.low, 10u);
+        UDO_ASSERT_NULL(lexer.literal(lexer.peek()));
+    });
+
+    literal_suite->add_test("values_survive_chunking_and_relex", []() {
+        Buffer buffer;
+        for (int i = 0; i < 200; ++i) buffer.data += "v = " + std::to_string(i) + ";\n";
+        Lexer lexer(buffer);
+        lexer.set_parallel_options({0, 64, 4});
+        auto tokens = lexer.tokenize();
+        UDO_ASSERT_EQ(tokens.literals().size(), 200u);
+        UDO_ASSERT_EQ(tokens.literal(tokens.size() - 4)->integer.low, 199u);
+
+        Lexer::relex(buffer, 0, tokens, {buffer.data.find("7;"), 1, "7 + 9"});
+        UDO_ASSERT_EQ(tokens.literals().size(), 201u);
+        UDO_ASSERT_EQ(tokens.literal(tokens.size() - 4)->integer.low, 199u);
+    });
+
+    runner.add_suite(std::move(literal_suite));
+
+    // ========================================================================
+    // Identifier Interning Tests
+    // ========================================================================
+
+    auto intern_suite = std::make_unique<TestSuite>("Lexer::IdentifierInterning");
+
+    // a throwaway arena for tables outside an ASTContext
+    struct Test_Arena {
+        std::vector<std::unique_ptr<char[]>> blocks;
+
+        static void* allocate(void* arena, const std::size_t size, const std::size_t) {
+            auto& blocks = static_cast<Test_Arena*>(arena)->blocks;
+            return blocks.emplace_back(std::make_unique<char[]>(size + alignof(std::max_align_t))).get();
+        }
+    };
+
+    intern_suite->add_test("identifiers_share_one_info", []() {
+        Test_Arena arena;
+        IdentifierTable table(&arena, Test_Arena::allocate);
+        Buffer buffer;
+        buffer.data = "let foo = bar + foo;\nfunctor bar() {}";
+        Lexer lexer(buffer);
+        lexer.set_identifier_table(&table);
+        auto tokens = lexer.tokenize();
+
+        UDO_ASSERT_NULL(tokens.identifier(0));
+        const IdentifierInfo* foo = tokens.identifier(1);
+        UDO_ASSERT_NOT_NULL(foo);
+        UDO_ASSERT_STREQ(foo->get_name(), "foo");
+        UDO_ASSERT_EQ(tokens.identifier(5), foo);
+        UDO_ASSERT_EQ(tokens[9].identifier, tokens.identifier(3));
+        UDO_ASSERT_EQ(table.size(), 2u);
+        UDO_ASSERT_EQ(table.find("bar"), tokens.identifier(3));
+        UDO_ASSERT_NULL(table.find("functor"));
+    });
+
+    intern_suite->add_test("streaming_and_chunked_lexing_intern_the_same", []() {
+        Test_Arena arena;
+        IdentifierTable table(&arena, Test_Arena::allocate);
+        Buffer buffer;
+        for (int i = 0; i < 400; ++i) buffer.data += "name" + std::to_string(i % 50) + " = other;\n";
+
+        Lexer chunked(buffer);
+        chunked.set_identifier_table(&table);
+        chunked.set_parallel_options({0, 256, 4});
+        auto tokens = chunked.tokenize();
+        UDO_ASSERT_EQ(table.size(), 51u);
+
+        Lexer streaming(buffer);
+        streaming.set_identifier_table(&table);
+        for (std::size_t i = 0; i < tokens.size(); ++i) {
+            UDO_ASSERT_EQ(streaming.next_token().identifier, tokens.identifier(i));
+        }
+        UDO_ASSERT_EQ(table.size(), 51u);
+    });
+
+    runner.add_suite(std::move(intern_suite));
 }
 
 } // namespace udo::test
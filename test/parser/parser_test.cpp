@@ -7,17 +7,22 @@
 #include <parser/parser.hpp>
 #include <lexer/lexer.hpp>
 #include <sstream>
+#include <deque>
 
 namespace udo::test {
 
 using namespace udo::lexer;
-
-// Helper function to tokenize a string for parser tests
-static std::vector<Token> tokenize_for_parser(const std::string& input) {
-    std::istringstream stream(input);
-    Lexer lexer(stream);
-    auto [tokens, unfiltered, lines] = lexer.tokenize();
-    return tokens;
+using udo::ast::ASTContext;
+using udo::parse::Parser;
+
+// Helper function to tokenize a string for parser tests. Lexemes view into the
+// lexed buffer, so every buffer is kept alive for the remainder of the test run.
+static TokenStream tokenize_for_parser(const std::string& input) {
+    static std::deque<Buffer> buffers;
+    Buffer& buffer = buffers.emplace_back();
+    buffer.data = input;
+    Lexer lexer(buffer);
+    return lexer.tokenize();
 }
 
 void register_parser_tests(TestRunner& runner) {
@@ -46,6 +51,33 @@ void register_parser_tests(TestRunner& runner) {
         UDO_ASSERT_TRUE(true);
     });
 
+    var_suite->add_test("comments_between_tokens_are_skipped", []() {
+        Buffer buffer;
+        buffer.data = "let /* name */ x /* type */ : i32 = 1; // done\n";
+        ASTContext context;
+        diag::DiagnosticsEngine diag;
+
+        Lexer lexer(buffer);
+        Parser(lexer, {}, context, diag).parse();
+        UDO_ASSERT_FALSE(diag.hasErrorOccurred());
+
+        TokenStream tokens = tokenize_for_parser(buffer.data);
+        TokenStream_Reader reader(tokens);
+        Parser(reader, {}, context, diag).parse();
+        UDO_ASSERT_FALSE(diag.hasErrorOccurred());
+    });
+
+    var_suite->add_test("stray_backslash_is_reported", []() {
+        Buffer buffer;
+        buffer.data = "let \\ x : i32 = 1;\n";
+        ASTContext context;
+        diag::DiagnosticsEngine diag;
+
+        Lexer lexer(buffer);
+        Parser(lexer, {}, context, diag).parse();
+        UDO_ASSERT_TRUE(diag.hasErrorOccurred());
+    });
+
     runner.add_suite(std::move(var_suite));
 
     // ========================================================================
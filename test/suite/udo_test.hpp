@@ -604,8 +604,8 @@ private:
 // String Assertions
 #define UDO_ASSERT_STREQ(actual, expected) \
     do { \
-        std::string a_str = (actual); \
-        std::string e_str = (expected); \
+        std::string a_str{(actual)}; \
+        std::string e_str{(expected)}; \
         if (a_str != e_str) { \
             std::ostringstream oss; \
             oss << "String mismatch:\n  Actual:   \"" << a_str \